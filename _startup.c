@@ -9,6 +9,7 @@
 
 #include "freedom.h"
 #include "common.h"
+#include "boot.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -19,6 +20,8 @@
 
 void _reset_init(void)    __attribute__((naked, aligned(8)));
 extern void _start(void);           /**< Newlib C lib initialization. */
+extern void __libc_init_array(void);    /**< Newlib constructors.       */
+extern int main(void);
 
 /**
     Flash configuration field (loaded into flash memory at 0x400)
@@ -432,26 +435,75 @@ static void init_led_io(void)
     TPM0_SC   = TPM_SC_CMOD(1) | TPM_SC_PS(0);     /* Edge Aligned PWM running from BUSCLK / 1 */
 }
 
+#ifdef FAST_BOOT
+/**
+ * \brief Copy words, four per ldm/stm pair.
+ */
+static void __attribute__((noinline)) copy_words (uint32_t *to, const uint32_t *fr, const uint32_t *end)
+{
+    uint32_t n = (end - to) >> 2;
+    while (n--) {
+        asm volatile ("ldmia %1!, {r3, r4, r5, r6}\n\t"
+                      "stmia %0!, {r3, r4, r5, r6}"
+                      : "+l" (to), "+l" (fr) :: "r3", "r4", "r5", "r6", "memory");
+    }
+    while (to < end)
+        *to++ = *fr++;
+}
+
+/**
+ * \brief Clear words, four per stm.
+ */
+static void __attribute__((noinline)) zero_words (uint32_t *to, const uint32_t *end)
+{
+    register uint32_t z3 asm("r3") = 0;
+    register uint32_t z4 asm("r4") = 0;
+    register uint32_t z5 asm("r5") = 0;
+    register uint32_t z6 asm("r6") = 0;
+    uint32_t n = (end - to) >> 2;
+    while (n--) {
+        asm volatile ("stmia %0!, {r3, r4, r5, r6}"
+                      : "+l" (to) : "r" (z3), "r" (z4), "r" (z5), "r" (z6) : "memory");
+    }
+    while (to < end)
+        *to++ = 0;
+}
+#endif
+
 /**
  * \brief Reset entry point.
  * The CPU reset vector points here. Initialize the CPU, and jump to 
  * the C runtime start, which will eventually invoke main().
+ * \note With FAST_BOOT the copy and clear loops move 16 bytes per
+ * iteration, and main() is called directly: newlib's _start would clear
+ * .bss a second time.
  */
 void _reset_init (void)
 {
     SIM_COPC = 0;   // Disable the watchdog timer   
     SCB_VTOR = (uint32_t)InterruptVector;
+    boot_counter_start();                   // Boot phase timestamps
 
-    // Copy values to initialize data segment
+#ifdef FAST_BOOT
+    copy_words(__data_start__, __etext, __data_end__);
+    zero_words(__bss_start__, __bss_end__);
+#else
+    // Copy values to initialize data segment (and the .ramfunc code)
     uint32_t *fr = __etext;
     uint32_t *to = __data_start__;
     unsigned int len = __data_end__ - __data_start__;
     while(len--)
         *to++ = *fr++;
+#endif
 
     init_clocks();
     init_led_io();
+#ifdef FAST_BOOT
+    __libc_init_array();
+    main();
+#else
     _start();                               // Goto C lib startup
+#endif
     fault(FAULT_FAST_BLINK);                // ...should never get here.
 }
 /** @} */
@@ -9,12 +9,14 @@
 
 #include <freedom.h>
 #include "common.h"
+#include "clock.h"
 
 #define MMA8451_I2C_ADDRESS (0x1d<<1)
 #define I2C_READ 1
 #define I2C_WRITE 0
 
 #define I2C0_B  I2C0_BASE_PTR
+#define I2C_SCL_HZ  300000          // Fastest SCL wanted (ICR=0x14 at 24 MHz)
 
 // ---------------------------------------------------------------------------
 // I2C bus control functions
@@ -57,6 +59,23 @@ inline int i2c_write(I2C_MemMapPtr p, uint8_t data)
     return ((p->S & I2C_S_RXAK_MASK) == 0);
 }
 
+// SCL divider per ICR value (MULT=0), a subset of the reference manual table
+static const struct { uint8_t icr; uint8_t div; } i2c_dividers[] = {
+    { 0x00, 20 }, { 0x05, 30 }, { 0x0D, 48 }, { 0x14, 80 },
+    { 0x17, 128 }, { 0x1D, 160 }, { 0x1F, 240 }
+};
+
+// Smallest divider that keeps SCL at or below I2C_SCL_HZ
+static void i2c_clock(const clock_info_t *clk)
+{
+    uint8_t i, last = sizeof(i2c_dividers) / sizeof(i2c_dividers[0]) - 1;
+    for (i = 0; i != last; i++) {
+        if (clk->bus / i2c_dividers[i].div <= I2C_SCL_HZ)
+            break;
+    }
+    I2C0_F = i2c_dividers[i].icr;
+}
+
 inline void i2c_init(I2C_MemMapPtr p)
 {
     // Enable clocks
@@ -67,7 +86,6 @@ inline void i2c_init(I2C_MemMapPtr p)
     PORTE_PCR24 = PORT_PCR_MUX(5);
     PORTE_PCR25 = PORT_PCR_MUX(5);
     
-    p->F  = 0x14;                   // Baudrate settings:  ICR=0x14, MULT=0
     p->C1 = I2C_C1_IICEN_MASK;      // Enable:  IICEN=1
 }
 
@@ -107,6 +125,8 @@ void accel_init(void)
     uint8_t tmp;
 
     i2c_init(I2C0_B);
+    i2c_clock(clock_info());        // Baudrate settings:  ICR, MULT=0
+    clock_notify(i2c_clock);
     tmp = mma8451_read(CTRL_REG1);
     mma8451_write(CTRL_REG1, tmp | 0x01);       // ACTIVE = 1
 }
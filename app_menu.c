@@ -33,6 +33,8 @@ char *AppStringSubmenu3[] = {
     "About",
     "Test LED",
     "Debug",
+    "Clock",
+    "Standby",
     "Back",
     ""
 };
@@ -62,36 +64,101 @@ void aPrint (char **str, uint8_t item) {
     aPrintExt (str, item, NULL);
 }
 
-void aPrintExt (char **str, uint8_t item, uint32_t *value) {
+/* Menu rows of a frame: the caller owns screen_begin/screen_end */
+static void aRows (char **str, uint8_t item, int32_t *value) {
+    fmt_t *f;
     uint8_t line;
-    ClearScreen ();
-    iprintf(" :: Menu ::\r\n");
+    fmt_str (screen_row(), " :: Menu ::");
     for (line = 0; strcmp(str[line], "") != 0; line ++) {
+        f = screen_row();
         if (line == item) {
-            if (value == NULL) {
-                iprintf("> %s\r\n", str[line]);
-            }
-            else {
-                iprintf("> %s: %li\r\n", str[line], *value);
+            fmt_str (f, "> ");
+            fmt_str (f, str[line]);
+            if (value != NULL) {
+                fmt_str (f, ": ");
+                fmt_i32 (f, *value, 0, ' ');
             }
         } 
         else {
-            printf("%s\r\n", str[line]);
+            fmt_str (f, str[line]);
         }
     }    
 }
 
+/* Trend rows of a channel, same figures as history_print */
+static void aHistoryRows (uint8_t channel) {
+    history_stat_t stat[HISTORY_SEC_LEN];
+    fmt_t *f;
+    uint8_t k, n;
+    screen_row ();
+    fmt_str (screen_row(), "   -s       min      mean       max");
+    n = history_rollup (channel, HISTORY_LEVEL_SEC, stat, HISTORY_SEC_LEN);
+    for (k = 0; k != n; k++) {
+        f = screen_row();
+        fmt_u32 (f, k + 1, 5, ' ');
+        fmt_i32 (f, stat[k].min, 10, ' ');
+        fmt_i32 (f, stat[k].mean, 10, ' ');
+        fmt_i32 (f, stat[k].max, 10, ' ');
+    }
+    fmt_str (screen_row(), "   -m       min      mean       max");
+    n = history_rollup (channel, HISTORY_LEVEL_MIN, stat, HISTORY_MIN_LEN);
+    for (k = 0; k != n; k++) {
+        f = screen_row();
+        fmt_u32 (f, k + 1, 5, ' ');
+        fmt_i32 (f, stat[k].min, 10, ' ');
+        fmt_i32 (f, stat[k].mean, 10, ' ');
+        fmt_i32 (f, stat[k].max, 10, ' ');
+    }
+}
+
+void aPrintExt (char **str, uint8_t item, int32_t *value) {
+    screen_begin ();
+    aRows (str, item, value);
+    screen_end ();
+}
+
 uint8_t chkLast (char **str, uint8_t item) {
     if (strcmp(str[item + 1], "") == 0) return TRUE;
     else return FALSE;
 }
 
+uint8_t lastItem (char **str) {
+    uint8_t item = 0;
+    while (chkLast(str, item) == FALSE) item ++;
+    return item;
+}
+
+/* Tick of the last live redraw */
+static uint32_t lastRefresh;
+
+/* TRUE when the task on screen is a live view due for a redraw */
+uint8_t aRefreshDue (void) {
+    if ((StateAppMenu != TASK) || (vSubmenu != 1)) return FALSE;
+    return (int32_t)(sysTicks - lastRefresh) >= APP_REFRESH_TICKS;
+}
+
+/* Work of a standby period: a 2 ms green blink */
+static void aStandbyBlink (void) {
+    RGB_LED(0, 100, 0);
+    delay_us (2000);
+    RGB_LED(0, 0, 0);
+}
+
 void aTask (char **str, uint8_t x, uint8_t y) {
+    sensor_snapshot_t snap;
+    int32_t value;
+    uint8_t profile;
     switch (x) {
         case 0: /* Submenu 0: Nothing to do*/
             break;
         case 1: /* Submenu 1: Print sensors*/
-            aPrintExt (str, y, &(sysBuffer[y]));
+            sensor_read (&snap);
+            value = sensor_value (&snap, y);
+            screen_begin ();
+            aRows (str, y, &value);
+            aHistoryRows (y);
+            screen_end ();
+            lastRefresh = sysTicks;
             break;
         case 2:
             switch(y) {
@@ -133,6 +200,52 @@ void aTask (char **str, uint8_t x, uint8_t y) {
                     iprintf("      clk ");
                     PrintHex((LPTMR0_CSR & LPTMR_CSR_TMS_MASK) >> LPTMR_CSR_TMS_SHIFT);
                     iprintf("\r\n");
+
+                    iprintf("Tone (A0):\r\n");
+                    iprintf("  enabled ");
+                    PrintHex(tone_enabled());
+                    iprintf("\r\n");
+                    iprintf(" detected ");
+                    PrintHex(tone_detected());
+                    iprintf("\r\n");
+                    iprintf("    50 Hz %lu\r\n", (unsigned long) tone_power(TONE_MAINS_50));
+                    iprintf("    60 Hz %lu\r\n", (unsigned long) tone_power(TONE_MAINS_60));
+                    iprintf("     1kHz %lu\r\n", (unsigned long) tone_power(TONE_PILOT));
+                    iprintf("  overrun %u late %u\r\n", sampler_overruns(), sampler_late());
+
+                    iprintf("Clock:\r\n");
+                    iprintf("  profile %u\r\n", clock_info()->profile);
+                    iprintf("     core %lu Hz\r\n", (unsigned long) clock_info()->core);
+                    iprintf("      bus %lu Hz\r\n", (unsigned long) clock_info()->bus);
+                    iprintf("Power:\r\n");
+                    power_print();
+                    iprintf("Boot:\r\n");
+                    boot_print();
+                    iprintf("RAM:\r\n");
+                    mem_print();
+                    iprintf("Pools:\r\n");
+                    pool_print();
+                    iprintf("DMA:\r\n");
+                    dma_print();
+#ifdef ISR_PROFILE
+                    iprintf("ISR cycles:\r\n");
+                    prof_print();
+#endif
+                    break;
+                case 3: /* Next clock profile: run, BLPI, VLPR (USB stops below run) */
+                    ClearScreen ();
+                    profile = (clock_info()->profile + 1) % CLOCK_PROFILES;
+                    iprintf("Clock: profile %u -> %u\r\n", clock_info()->profile, profile);
+                    clock_set (profile);
+                    iprintf("     core %lu Hz\r\n", (unsigned long) clock_info()->core);
+                    iprintf("      bus %lu Hz\r\n", (unsigned long) clock_info()->bus);
+                    break;
+                case 4: /* Duty cycle: stop between LPTMR wakes, 10 x 1 s or a key on the UART */
+                    ClearScreen ();
+                    iprintf("Standby: 10 x 1 s, a key on the UART ends it\r\n");
+                    value = power_standby (1000, 10, aStandbyBlink);
+                    iprintf("  %ld periods\r\n", (long) value);
+                    power_print ();
                     break;
             }
             break;
@@ -141,8 +254,13 @@ void aTask (char **str, uint8_t x, uint8_t y) {
 
 void ClearScreen (void) {
     iprintf("\033[2J\033[1;1H");
+    screen_invalidate ();
 }
 
 void PrintHex (uint32_t num){
-    iprintf("%#04x", num);
+    char buffer[12];
+    fmt_t f;
+    fmt_init (&f, buffer, sizeof(buffer));
+    fmt_hex (&f, num, 2);
+    fmt_flush (&f);
 }
@@ -6,6 +6,19 @@
 #include <stdio.h>
 #include "types.h"
 #include "main.h"
+#include "history.h"
+#include "tone.h"
+#include "boot.h"
+#include "clock.h"
+#include "dma.h"
+#include "fmt.h"
+#include "memory.h"
+#include "pool.h"
+#include "power.h"
+#include "profile.h"
+#include "sampler.h"
+#include "screen.h"
+#include "timebase.h"
 #include "common.h"
 
 /* Events of menu */
@@ -13,6 +26,8 @@ extern enum _EventsAppMenu
 {
     eSelect,
     eUp,
+    eDown,
+    eBack,
     eNoEvent
 };
 
@@ -25,6 +40,8 @@ extern enum _StateAppMenu {
 
 #define STATE_START MENU
 
+#define APP_REFRESH_TICKS   10  // Live task views redraw every 100 ms
+
 extern char *AppStringMenu[];
 
 extern char *AppStringSubmenu1[];
@@ -45,12 +62,16 @@ extern uint8_t vSubmenu;
 // Acciones:
 extern void aPrint (char **str, uint8_t item);
 
-void aPrintExt (char **str, uint8_t item, uint32_t *value);
+void aPrintExt (char **str, uint8_t item, int32_t *value);
 
 extern uint8_t chkLast (char **str, uint8_t item);
 
+extern uint8_t lastItem (char **str);
+
 extern void aTask (char **str, uint8_t x, uint8_t y);
 
+extern uint8_t aRefreshDue (void);
+
 extern void InitAppMenu (void); 
 extern void ClearScreen (void);
 extern void PrintHex (uint32_t num);
@@ -0,0 +1,87 @@
+/**
+    \file boot.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Boot phase timestamps. Until \ref boot_ticking the count is
+    the 24-bit SysTick value started by the reset handler (350 ms at
+    48 MHz, far more than the way to main). Cycles spent before the PLL
+    runs are counted as 48 MHz cycles, so that phase reads short.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "boot.h"
+
+#define CYCLES_PER_US   (CORE_CLOCK / 1000000)
+
+static uint32_t stamps[BOOT_PHASES];
+static uint8_t marked;                  // Bit per phase
+static uint32_t base;                   // us at the hand over to 10 ms ticks
+static uint8_t ticking;
+
+static const char *const names[BOOT_PHASES] = {
+    "main", "drivers", "scheduler", "first sample"
+};
+
+static uint32_t now_us (void)
+{
+    uint32_t ticks, cvr;
+
+    if (!ticking)
+        return (SysTick_RVR_RELOAD_MASK - SYST_CVR) / CYCLES_PER_US;
+    do {                                // A tick between both reads: again
+        ticks = sysTicks;
+        cvr = SYST_CVR;
+    } while (ticks != sysTicks);
+    return base + (ticks * (SYST_RVR + 1) + (SYST_RVR - cvr)) / CYCLES_PER_US;
+}
+
+/**
+    \brief Record the time of a phase; only the first call counts.
+    \param phase See \ref bootPhase.
+*/
+void boot_mark (uint8_t phase)
+{
+    if (phase >= BOOT_PHASES || (marked & (1 << phase)))
+        return;
+    stamps[phase] = now_us();
+    marked |= 1 << phase;
+}
+
+/**
+    \brief Leave the free running count: call right before SysTick gets
+    its tick period, with sysTicks still at zero.
+*/
+void boot_ticking (void)
+{
+    base = now_us();
+    ticking = TRUE;
+}
+
+/**
+    \brief Microseconds from reset to a phase, 0 when not reached yet.
+*/
+uint32_t boot_time (uint8_t phase)
+{
+    if (phase >= BOOT_PHASES || !(marked & (1 << phase)))
+        return 0;
+    return stamps[phase];
+}
+
+/**
+    \brief Print the boot phases on the console.
+*/
+void boot_print (void)
+{
+    uint8_t phase;
+
+#ifdef FAST_BOOT
+    iprintf("  fast boot\r\n");
+#endif
+    for (phase = 0; phase != BOOT_PHASES; phase++)
+        iprintf("  %12s %8lu us\r\n", names[phase], (unsigned long) boot_time(phase));
+}
@@ -0,0 +1,52 @@
+/**
+    \file boot.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Boot phase timestamps, in microseconds since reset. SysTick
+    counts core cycles free running from the reset handler until main
+    gives it the 10 ms period; later phases add whole ticks.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _BOOT_H_
+#define _BOOT_H_
+
+#include <stdint.h>
+#include "types.h"
+#include "freedom.h"
+
+/**
+    \addtogroup Boot
+    @{
+*/
+
+/** \brief Phases, in boot order. */
+enum bootPhase {
+    bootMain,                   /**< main() entered: data, clocks, C runtime. */
+    bootDrivers,                /**< Drivers and modules initialized.         */
+    bootScheduler,              /**< First pass of the scheduler.             */
+    bootFirstSample,            /**< First ADC scan published.                */
+    BOOT_PHASES
+};
+
+/**
+    \brief Start SysTick free running over 24 bits. First thing of the
+    reset handler: touches no RAM, as .data and .bss are not ready.
+*/
+static inline void boot_counter_start (void)
+{
+    SYST_RVR = SysTick_RVR_RELOAD_MASK;
+    SYST_CVR = 0;
+    SYST_CSR = SysTick_CSR_CLKSOURCE_MASK | SysTick_CSR_ENABLE_MASK;
+}
+
+void boot_mark (uint8_t phase);
+void boot_ticking (void);
+uint32_t boot_time (uint8_t phase);
+void boot_print (void);
+
+/** @} */ // Boot
+
+#endif  // _BOOT_H_
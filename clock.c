@@ -0,0 +1,200 @@
+/**
+    \file clock.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Clock profiles. _startup.c leaves the MCG in PEE; the way down
+    is PEE -> PBE -> FBE -> FBI -> BLPI (-> VLPR) and the same steps in
+    reverse lead back up. The slow profiles run everything from the 4 MHz
+    IRC, so UART0 and the TPMs move to MCGIRCLK; USB needs the PLL and
+    stops until \ref clockRun is selected again.
+    \note Callbacks run with interrupts enabled: the \ref clock_prepare
+    ones before the MCG is touched, the \ref clock_notify ones after the
+    new clocks are stable and before \ref clock_set returns.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include "freedom.h"
+#include "common.h"
+#include "clock.h"
+
+#define IRC_FAST        4000000     // Fast IRC, FCRDIV = 0
+#define PLL_OUT         96000000    // 8 MHz crystal / 2 * 24
+
+#define CLKST_FLL       0           // MCG_S[CLKST] values
+#define CLKST_IRC       1
+#define CLKST_EXT       2
+#define CLKST_PLL       3
+
+#define PMSTAT_RUN      0x01
+#define PMSTAT_VLPR     0x04
+
+static const clock_info_t profiles[CLOCK_PROFILES] = {
+    { PLL_OUT / 2,  PLL_OUT / 4,  PLL_OUT / 2,  clockRun  },
+    { IRC_FAST,     IRC_FAST / 4, IRC_FAST,     clockBlpi },
+    { IRC_FAST,     IRC_FAST / 4, IRC_FAST,     clockVlpr },
+};
+
+static const clock_info_t *active = &profiles[clockRun];
+static clock_notify_t callbacks[CLOCK_CALLBACKS];
+static uint8_t ncallbacks;
+static clock_notify_t prepare[CLOCK_CALLBACKS];
+static uint8_t nprepare;
+
+static inline void wait_clkst (uint8_t clkst)
+{
+    while ((MCG_S & MCG_S_CLKST_MASK) != MCG_S_CLKST(clkst))
+        ;
+}
+
+// PEE -> BLPI.  IRCLKEN stays set on the way: IRCST only follows IRCS
+// while the IRC runs, and nothing else enables it before FBI
+static void to_blpi (void)
+{
+    MCG_C1 = MCG_C1_CLKS(2) | MCG_C1_FRDIV(3) | MCG_C1_IRCLKEN_MASK;  // PBE
+    wait_clkst(CLKST_EXT);
+    MCG_C6 &= ~MCG_C6_PLLS_MASK;                        // FBE
+    while (MCG_S & MCG_S_PLLST_MASK)
+        ;
+    MCG_SC &= ~MCG_SC_FCRDIV_MASK;                      // 4 MHz IRC
+    MCG_C2 |= MCG_C2_IRCS_MASK;
+    while (!(MCG_S & MCG_S_IRCST_MASK))
+        ;
+    MCG_C1 = MCG_C1_CLKS(1) | MCG_C1_FRDIV(3) | MCG_C1_IREFS_MASK
+           | MCG_C1_IRCLKEN_MASK | MCG_C1_IREFSTEN_MASK;  // FBI
+    wait_clkst(CLKST_IRC);
+    MCG_C2 |= MCG_C2_LP_MASK;                           // BLPI: FLL off
+    SIM_CLKDIV1 = SIM_CLKDIV1_OUTDIV1(0) | SIM_CLKDIV1_OUTDIV4(3);
+    SIM_SOPT2 = (SIM_SOPT2 & ~(SIM_SOPT2_UART0SRC_MASK | SIM_SOPT2_TPMSRC_MASK))
+              | SIM_SOPT2_UART0SRC(3) | SIM_SOPT2_TPMSRC(3);
+}
+
+// BLPI -> PEE, as init_clocks() does from FEI
+static void to_pee (void)
+{
+    SIM_CLKDIV1 = SIM_CLKDIV1_OUTDIV1(1) | SIM_CLKDIV1_OUTDIV4(1);
+    MCG_C2 &= ~MCG_C2_LP_MASK;                          // FBI
+    MCG_C1 = MCG_C1_CLKS(2) | MCG_C1_FRDIV(3) | MCG_C1_IRCLKEN_MASK;  // FBE
+    while (MCG_S & MCG_S_IREFST_MASK)
+        ;
+    wait_clkst(CLKST_EXT);
+    MCG_C6 = MCG_C6_PLLS_MASK;                          // PBE
+    while (!(MCG_S & MCG_S_LOCK0_MASK))
+        ;
+    MCG_C1 = MCG_C1_FRDIV(3) | MCG_C1_IRCLKEN_MASK;     // PEE
+    wait_clkst(CLKST_PLL);
+    SIM_SOPT2 = (SIM_SOPT2 & ~(SIM_SOPT2_UART0SRC_MASK | SIM_SOPT2_TPMSRC_MASK))
+              | SIM_SOPT2_UART0SRC(1) | SIM_SOPT2_TPMSRC(1);
+}
+
+static void vlpr (uint8_t enter)
+{
+    if (enter) {
+        SMC_PMCTRL = (SMC_PMCTRL & ~SMC_PMCTRL_RUNM_MASK) | SMC_PMCTRL_RUNM(2);
+        while (SMC_PMSTAT != PMSTAT_VLPR)
+            ;
+    }
+    else {
+        SMC_PMCTRL &= ~SMC_PMCTRL_RUNM_MASK;
+        while (!(PMC_REGSC & PMC_REGSC_REGONS_MASK))    // Regulator in run
+            ;
+        while (SMC_PMSTAT != PMSTAT_RUN)
+            ;
+    }
+}
+
+/**
+    \brief Take over the clocks left by _startup.c (PEE). SMC_PMPROT is
+    write-once: every low power mode is allowed here.
+*/
+void clock_init (void)
+{
+    SMC_PMPROT = SMC_PMPROT_AVLP_MASK | SMC_PMPROT_ALLS_MASK | SMC_PMPROT_AVLLS_MASK;
+    active = &profiles[clockRun];
+    ncallbacks = 0;
+    nprepare = 0;
+}
+
+/**
+    \brief Switch to a profile and run the callbacks.
+    \param profile See \ref clockProfile.
+    \return 0, or -1 for an unknown profile.
+*/
+int clock_set (uint8_t profile)
+{
+    uint8_t from, i;
+
+    if (profile >= CLOCK_PROFILES)
+        return -1;
+    from = active->profile;
+    if (profile == from)
+        return 0;
+
+    for (i = 0; i != nprepare; i++)
+        prepare[i](&profiles[profile]);
+    if (from == clockVlpr)
+        vlpr(FALSE);                    // VLPR only leaves to RUN
+    if (from == clockRun)
+        to_blpi();
+    if (profile == clockRun)
+        to_pee();
+    if (profile == clockVlpr)
+        vlpr(TRUE);
+
+    active = &profiles[profile];
+    for (i = 0; i != ncallbacks; i++)
+        callbacks[i](active);
+    return 0;
+}
+
+/**
+    \brief Back from a stop mode: the MCG wakes in PBE (CLKS forced to
+    the external clock), so \ref clockRun goes back to PEE once the PLL
+    has relocked. The slow profiles run from the IRC, which is ready at
+    once.
+*/
+void clock_resume (void)
+{
+    if (active->profile == clockRun) {
+        while (!(MCG_S & MCG_S_LOCK0_MASK))
+            ;
+        MCG_C1 &= ~MCG_C1_CLKS_MASK;                    // PEE
+        wait_clkst(CLKST_PLL);
+    }
+}
+
+/**
+    \brief Clocks of the active profile.
+*/
+const clock_info_t *clock_info (void)
+{
+    return active;
+}
+
+/**
+    \brief Register a callback run after every switch. It is not called
+    at registration: use \ref clock_info for the first setup.
+    \return FALSE when the table is full.
+*/
+uint8_t clock_notify (clock_notify_t fn)
+{
+    if (ncallbacks == CLOCK_CALLBACKS)
+        return FALSE;
+    callbacks[ncallbacks++] = fn;
+    return TRUE;
+}
+
+/**
+    \brief Register a callback run before every switch, with the clocks
+    of the profile about to be selected: the place to let a transfer
+    timed on the old clocks finish.
+    \return FALSE when the table is full.
+*/
+uint8_t clock_prepare (clock_notify_t fn)
+{
+    if (nprepare == CLOCK_CALLBACKS)
+        return FALSE;
+    prepare[nprepare++] = fn;
+    return TRUE;
+}
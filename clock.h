@@ -0,0 +1,54 @@
+/**
+    \file clock.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Clock profiles switched at run time. Drivers whose dividers
+    depend on a clock register a callback and recompute them after
+    every switch; a driver with a transfer in flight can also register
+    one that runs before.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _CLOCK_H_
+#define _CLOCK_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Clock
+    @{
+*/
+
+#define CLOCK_CALLBACKS     6       /**< Callbacks per table (before, after).  */
+
+/** \brief Profiles, fastest first. */
+enum clockProfile {
+    clockRun,               /**< PEE: 48 MHz core, 24 MHz bus, USB works.      */
+    clockBlpi,              /**< BLPI: 4 MHz core, 1 MHz bus, from the IRC.     */
+    clockVlpr,              /**< BLPI clocks with the regulator in VLPR.        */
+    CLOCK_PROFILES
+};
+
+/** \brief Clock tree of the active profile, in Hz. */
+typedef struct {
+    uint32_t core;          /**< Core and SysTick.                             */
+    uint32_t bus;           /**< Bus and flash: I2C, ADC, PIT.                 */
+    uint32_t periph;        /**< UART0 and TPM source (PLL/2 or MCGIRCLK).      */
+    uint8_t  profile;       /**< See \ref clockProfile.                        */
+} clock_info_t;
+
+typedef void (*clock_notify_t) (const clock_info_t *clk);
+
+void clock_init (void);
+int clock_set (uint8_t profile);
+void clock_resume (void);
+const clock_info_t *clock_info (void);
+uint8_t clock_notify (clock_notify_t fn);
+uint8_t clock_prepare (clock_notify_t fn);
+
+/** @} */ // Clock
+
+#endif  // _CLOCK_H_
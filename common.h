@@ -13,20 +13,33 @@
 
 // Memory locations defined by the linker
 extern uint32_t __heap_start[];
-extern uint32_t __StackTop[];
+extern uint32_t __StackTop[], __StackLimit[];
 extern uint32_t __data_start__[], __data_end__[];
 extern uint32_t __bss_start__[], __bss_end__[];
 extern uint32_t __etext[];                // End of code/flash
 
+// Code run from RAM, free of flash wait states: the .ramfunc section is
+// copied with .data at reset. Build with -DRAMFUNC_IN_FLASH to compare.
+#ifdef RAMFUNC_IN_FLASH
+#define RAMFUNC
+#else
+#define RAMFUNC __attribute__ ((section(".ramfunc"), long_call, noinline))
+#endif
+
 // From uart.c
 void UART0_IRQHandler() __attribute__((interrupt("IRQ")));
 int uart_write(char *p, int len);
 int uart_write_err(char *p, int len);
 int uart_read(char *p, int len);
+int uart_available(void);
+int uart_tx_idle(void);
 void uart_init(int baud_rate);
 
 // From delay.c
 void delay(unsigned int ms);
+uint32_t lptmr_ms(void);
+void lptmr_alarm(uint16_t ms);
+uint8_t lptmr_alarm_pending(void);
 
 // From accel.c
 void accel_init(void);
@@ -45,9 +58,18 @@ void fault(uint32_t pattern);
 #define FAULT_MEDIUM_BLINK  (0b11110000111100001111000011110000)
 #define FAULT_SLOW_BLINK    (0b11111111000000001111111100000000)
 
+// From main.c
+extern volatile uint32_t sysTicks;      // SysTick periods (10 ms) since boot
+
 // usb.c
 void usb_init(void);
 void usb_dump(void);
+int cdc_write(const char *p, int len);
+int cdc_read(char *p, int len);
+int cdc_available(void);
+int cdc_connected(void);
+void usb_stream_callback(void (*done)(uint8_t *data));
+int usb_stream_submit(uint8_t *data, uint16_t len);
 
 // adc.c
 //void ADC0_IRQHandler()  __attribute__((interrupt("IRQ")));
@@ -59,8 +81,33 @@ static inline void enable_irq(int n) {
 }
 // TODO:  IRQ disable
 
+#ifdef HOST_MODEL
+// Host build (tools/usbmodel.h): one thread, and the model calls the
+// interrupt handler itself between transactions, so there is nothing
+// to mask
+static inline void __enable_irq(void)   { }
+static inline void __disable_irq(void)  { }
+static inline void __dmb(void)          { }
+static inline uint32_t __irq_save(void) { return 0; }
+static inline void __irq_restore(uint32_t primask) { (void) primask; }
+#else
 static inline void __enable_irq(void)   { asm volatile ("cpsie i"); }
 static inline void __disable_irq(void)  { asm volatile ("cpsid i"); }
+static inline void __dmb(void)          { asm volatile ("dmb" ::: "memory"); }
+
+// Save PRIMASK and mask interrupts, for short nestable critical sections
+static inline uint32_t __irq_save(void)
+{
+    uint32_t primask;
+    asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) :: "memory");
+    return primask;
+}
+
+static inline void __irq_restore(uint32_t primask)
+{
+    asm volatile ("msr primask, %0" :: "r" (primask) : "memory");
+}
+#endif
 
 // ring.c
 typedef struct {
@@ -76,6 +123,9 @@ int buf_isfull(const RingBuffer *buf);
 int buf_isempty(const RingBuffer *buf);
 uint8_t buf_get_byte(RingBuffer *buf);
 void buf_put_byte(RingBuffer *buf, uint8_t val);
+int buf_free(const RingBuffer *buf);
+int buf_write(RingBuffer *buf, const uint8_t *src, int len);
+int buf_read(RingBuffer *buf, uint8_t *dst, int len);
 
 // tests.c
 void tests(void);
@@ -0,0 +1,161 @@
+/**
+    \file console.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Console backends. USB CDC takes over stdin/stdout once the host
+    opens the port (DTR) and UART0 is used otherwise, so the switch and
+    the fallback on disconnect need no action from the application.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stddef.h>
+#include "freedom.h"
+#include "common.h"
+#include "console.h"
+#include "timebase.h"
+
+static const console_backend_t *backends[CONSOLE_MAX_BACKENDS];
+static uint8_t count;
+
+// A backend that accepted nothing for CONSOLE_STALL_US is skipped by
+// console_write (the rest goes to UART0) until it takes bytes again,
+// so a host that keeps the port open but stops reading costs one wait
+static const console_backend_t *stalled;
+
+static volatile uint32_t written;       // Bytes out since boot
+
+static int uart_ready (void)
+{
+    return 1;                       // Always there: the fallback
+}
+
+static int uart_read_nb (char *p, int len)
+{
+    int n = uart_available();
+    if (n > len)
+        n = len;
+    return (n > 0) ? uart_read(p, n) : 0;
+}
+
+static int uart_write_all (const char *p, int len)
+{
+    return uart_write((char *) p, len);
+}
+
+static const console_backend_t uart_backend = {
+    .name  = "uart0",
+    .write = uart_write_all,
+    .read  = uart_read_nb,
+    .ready = uart_ready
+};
+
+static const console_backend_t cdc_backend = {
+    .name  = "usb-cdc",
+    .write = cdc_write,
+    .read  = cdc_read,
+    .ready = cdc_connected
+};
+
+static inline uint32_t in_interrupt (void)
+{
+    uint32_t ipsr;
+    asm volatile ("mrs %0, ipsr" : "=r" (ipsr));
+    return ipsr;
+}
+
+/**
+    \brief Register the built-in backends: USB CDC first, UART0 as the
+    fallback.
+*/
+void console_init (void)
+{
+    count = 0;
+    console_add(&cdc_backend);
+    console_add(&uart_backend);
+}
+
+/**
+    \brief Append a backend; earlier backends take precedence.
+    \return 0 on success, -1 if the table is full.
+*/
+int console_add (const console_backend_t *backend)
+{
+    if (count == CONSOLE_MAX_BACKENDS)
+        return -1;
+    backends[count++] = backend;
+    return 0;
+}
+
+/**
+    \return The backend that carries the console right now.
+*/
+const console_backend_t *console_active (void)
+{
+    uint8_t i;
+    for (i = 0; i != count; i++) {
+        if (backends[i]->ready())
+            return backends[i];
+    }
+    return &uart_backend;
+}
+
+/**
+    \brief Write to the active backend, following it if it changes while
+    waiting for room. A backend that makes no progress for
+    CONSOLE_STALL_US is given up on and the rest goes to UART0. From an
+    interrupt handler a partial write is not retried: the backend may
+    need that same interrupt to drain.
+    \return len, or the bytes accepted when called from an interrupt.
+*/
+int console_write (const char *p, int len)
+{
+    const console_backend_t *backend;
+    uint32_t since = time_us32();
+    int n, done = 0;
+
+    while (done < len) {
+        backend = console_active();
+        n = backend->write(p + done, len - done);
+        done += n;
+        if (n != 0) {
+            since = time_us32();
+            if (backend == stalled)
+                stalled = NULL;
+            continue;
+        }
+        if (in_interrupt())
+            break;
+        if (backend != &uart_backend && (backend == stalled
+                || time_us32() - since >= CONSOLE_STALL_US)) {
+            stalled = backend;
+            done += uart_write_all(p + done, len - done);
+        }
+    }
+    written += done;
+    return done;
+}
+
+/**
+    \brief Bytes written since boot, whoever wrote them: a renderer that
+    keeps a model of the terminal compares it across its own writes.
+*/
+uint32_t console_written (void)
+{
+    return written;
+}
+
+/**
+    \brief Read at least one byte from the active backend (blocking).
+    \return Bytes read.
+*/
+int console_read (char *p, int len)
+{
+    int n;
+
+    do {
+        n = console_active()->read(p, len);
+    } while (n == 0);
+    return n;
+}
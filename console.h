@@ -0,0 +1,43 @@
+/**
+    \file console.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Console backends for stdin/stdout: the first backend that is
+    ready, in registration order, carries the console.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _CONSOLE_H_
+#define _CONSOLE_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Console
+    @{
+*/
+
+#define CONSOLE_MAX_BACKENDS    4   /**< Room in the backend table.        */
+#define CONSOLE_STALL_US    50000   /**< No progress: fall back to UART0.  */
+
+/** \brief A console transport. */
+typedef struct {
+    const char *name;
+    int (*write) (const char *p, int len);  /**< Bytes accepted, may be partial. */
+    int (*read) (char *p, int len);         /**< Non-blocking, bytes read.       */
+    int (*ready) (void);                    /**< Non-zero when usable now.       */
+} console_backend_t;
+
+void console_init (void);
+int console_add (const console_backend_t *backend);
+const console_backend_t *console_active (void);
+int console_write (const char *p, int len);
+uint32_t console_written (void);
+int console_read (char *p, int len);
+
+/** @} */ // Console
+
+#endif  // _CONSOLE_H_
@@ -10,25 +10,87 @@
 #include <freedom.h>
 #include "common.h"
 
+static uint32_t ms_base;                // Count at the last restart, plus wraps
+static uint16_t ms_last;
+
+/**
+ * \brief Milliseconds since the first call.
+ * \note  The low power timer (LPTMR) runs free from the 1 kHz LPO, so
+ * the count goes on in every stop mode; call at least once per 65 s.
+ * Main loop only.
+ */
+uint32_t lptmr_ms (void)
+{
+    uint16_t cnr;
+
+    if (!(LPTMR0_CSR & LPTMR_CSR_TEN_MASK)) {
+        SIM_SCGC5 |= SIM_SCGC5_LPTMR_MASK;  // Make sure clock is enabled
+        LPTMR0_CSR = 0;                     // Reset LPTMR settings
+        LPTMR0_CMR = 0;
+
+        // Use 1kHz LPO with no prescaler
+        LPTMR0_PSR = LPTMR_PSR_PCS(1) | LPTMR_PSR_PBYP_MASK;
+
+        // Free running: the counter is not reset on compare
+        LPTMR0_CSR = LPTMR_CSR_TFC_MASK | LPTMR_CSR_TEN_MASK;
+    }
+    LPTMR0_CNR = 0;                         // Latch the counter to read it
+    cnr = LPTMR0_CNR;
+    if (cnr < ms_last)
+        ms_base += 1 << 16;
+    ms_last = cnr;
+    return ms_base + cnr;
+}
+
+/**
+ * \brief Raise the LPTMR interrupt once, \p ms milliseconds from now
+ * (1 to 65535); 0 cancels the alarm. Wakes the core from every stop mode.
+ * \note  The compare register only takes a new value while the timer is
+ * off, so the counter restarts here; lptmr_ms() goes on from the same
+ * count, losing at most one tick. Main loop only.
+ */
+void lptmr_alarm (uint16_t ms)
+{
+    uint32_t now = lptmr_ms();              // Also starts the timer
+
+    if (ms == 0) {
+        LPTMR0_CSR = LPTMR_CSR_TFC_MASK | LPTMR_CSR_TEN_MASK;  // TIE off
+        return;
+    }
+    LPTMR0_CSR = 0;                         // Off: counter and TCF cleared
+    ms_base = now;
+    ms_last = 0;
+    LPTMR0_CMR = ms - 1;                    // TCF on the tick after a match
+    LPTMR0_CSR = LPTMR_CSR_TFC_MASK | LPTMR_CSR_TIE_MASK | LPTMR_CSR_TEN_MASK;
+    enable_irq(INT_LPTimer);
+}
+
+/**
+ * \brief TRUE while an alarm is set and its interrupt has not run.
+ */
+uint8_t lptmr_alarm_pending (void)
+{
+    return (LPTMR0_CSR & LPTMR_CSR_TIE_MASK) != 0;
+}
+
+/**
+ * \brief Alarm: one shot, the interrupt is disabled again.
+ */
+void LPTimer_IRQHandler() __attribute__((interrupt("IRQ")));
+void LPTimer_IRQHandler(void)
+{
+    LPTMR0_CSR = LPTMR_CSR_TCF_MASK | LPTMR_CSR_TFC_MASK | LPTMR_CSR_TEN_MASK;
+}
+
 /**
  * \brief Spin wait delay.
  * \param length_ms Delay in milliseconds.
  * 
- * \note  Uses low power timer (LPTMR).
+ * \note  Uses low power timer (LPTMR), see lptmr_ms().
  */
 void delay (unsigned int length_ms)
 {
-    SIM_SCGC5 |= SIM_SCGC5_LPTMR_MASK;  // Make sure clock is enabled
-    LPTMR0_CSR = 0;                     // Reset LPTMR settings         
-    LPTMR0_CMR = length_ms;             // Set compare value (in ms)
-
-    // Use 1kHz LPO with no prescaler
-    LPTMR0_PSR = LPTMR_PSR_PCS(1) | LPTMR_PSR_PBYP_MASK;
-    
-    // Start the timer and wait for it to reach the compare value
-    LPTMR0_CSR = LPTMR_CSR_TEN_MASK;
-    while (!(LPTMR0_CSR & LPTMR_CSR_TCF_MASK))
+    uint32_t start = lptmr_ms();
+    while (lptmr_ms() - start <= length_ms)
         ;
-    
-    LPTMR0_CSR = 0;                     // Turn off timer
 }
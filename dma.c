@@ -0,0 +1,408 @@
+/**
+    \file dma.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief DMA service. A channel belongs to one driver between
+    \ref dma_alloc and \ref dma_free. Peripheral transfers move one unit
+    per request (cycle steal); memory transfers with \ref DMA_SRC_NONE
+    run at once from a software start. Chains are followed in software,
+    descriptor after descriptor, by the channel interrupt.
+    \note Copies: \ref dma_memcpy_async and \ref dma_memset_async share
+    one memory channel, taken on first use. Short copies, or any copy
+    while that channel is busy, are done by the CPU at once.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "freedom.h"
+#include "common.h"
+#include "dma.h"
+#include "pool.h"
+
+typedef struct {
+    const dma_desc_t *desc;         // Running descriptor
+    dma_callback_t   done;
+    void             *arg;
+    uint8_t          source;
+    uint8_t          used;
+} channel_t;
+
+static channel_t channels[DMA_CHANNELS];
+
+#define BENCH_SIZES     6           // 16 to 512 bytes
+#define BENCH_RUNS      3           // Best of, to skip a SysTick interrupt
+
+static int8_t copyCh = -1;          // Memory channel of the copies
+static dma_desc_t copyDesc;
+static uint32_t fillWord;           // Source of a memset
+static uint32_t threshold = DMA_COPY_THRESHOLD;
+static uint16_t benchCpu[BENCH_SIZES], benchDma[BENCH_SIZES];  // Cycles
+
+// DCR transfer size field: 0 = 32 bits, 1 = 8 bits, 2 = 16 bits
+static const uint8_t dcr_size[3] = { 1, 2, 0 };
+
+// Program a descriptor; the channel is idle
+static RAMFUNC int load (uint8_t ch, const dma_desc_t *d)
+{
+    uint8_t width = (d->flags >> 2) & 3;
+    uint32_t dcr;
+
+    if (width > 2 || d->bytes == 0 || d->bytes > DMA_DSR_BCR_BCR_MASK ||
+        (d->bytes & ((1 << width) - 1)))
+        return DMA_ERR_CONFIG;
+
+    dcr = DMA_DCR_EINT_MASK | DMA_DCR_SSIZE(dcr_size[width]) | DMA_DCR_DSIZE(dcr_size[width]);
+    if (d->flags & DMA_SRC_INC)
+        dcr |= DMA_DCR_SINC_MASK;
+    if (d->flags & DMA_DST_INC)
+        dcr |= DMA_DCR_DINC_MASK;
+
+    DMA_DSR_BCR_REG(DMA_BASE_PTR, ch) = DMA_DSR_BCR_DONE_MASK;    // Clear status
+    DMA_SAR_REG(DMA_BASE_PTR, ch) = (uint32_t) d->src;
+    DMA_DAR_REG(DMA_BASE_PTR, ch) = (uint32_t) d->dst;
+    DMA_DSR_BCR_REG(DMA_BASE_PTR, ch) = DMA_DSR_BCR_BCR(d->bytes);
+    if (channels[ch].source == DMA_SRC_NONE)
+        DMA_DCR_REG(DMA_BASE_PTR, ch) = dcr | DMA_DCR_START_MASK;
+    else
+        DMA_DCR_REG(DMA_BASE_PTR, ch) = dcr | DMA_DCR_CS_MASK | DMA_DCR_ERQ_MASK | DMA_DCR_D_REQ_MASK;
+    return DMA_OK;
+}
+
+// End of a descriptor: next one of the chain, or the callback
+static RAMFUNC void finish (uint8_t ch, int status)
+{
+    channel_t *c = &channels[ch];
+    const dma_desc_t *next = c->desc ? c->desc->next : NULL;
+
+    if (status == DMA_OK && next != NULL) {
+        c->desc = next;
+        status = load(ch, next);
+        if (status == DMA_OK)
+            return;
+    }
+    c->desc = NULL;
+    if (c->done)
+        c->done(ch, status, c->arg);
+}
+
+static RAMFUNC void irq (uint8_t ch)
+{
+    uint32_t dsr = DMA_DSR_BCR_REG(DMA_BASE_PTR, ch);
+    int status = DMA_OK;
+
+    if (dsr & DMA_DSR_BCR_CE_MASK)
+        status = DMA_ERR_CONFIG;
+    else if (dsr & DMA_DSR_BCR_BES_MASK)
+        status = DMA_ERR_SOURCE;
+    else if (dsr & DMA_DSR_BCR_BED_MASK)
+        status = DMA_ERR_DEST;
+    DMA_DSR_BCR_REG(DMA_BASE_PTR, ch) = DMA_DSR_BCR_DONE_MASK;
+    finish(ch, status);
+}
+
+void DMA0_IRQHandler() __attribute__((interrupt("IRQ")));
+RAMFUNC void DMA0_IRQHandler(void) { irq(0); }
+void DMA1_IRQHandler() __attribute__((interrupt("IRQ")));
+RAMFUNC void DMA1_IRQHandler(void) { irq(1); }
+void DMA2_IRQHandler() __attribute__((interrupt("IRQ")));
+RAMFUNC void DMA2_IRQHandler(void) { irq(2); }
+void DMA3_IRQHandler() __attribute__((interrupt("IRQ")));
+RAMFUNC void DMA3_IRQHandler(void) { irq(3); }
+
+/**
+    \brief Clock the DMA and the DMAMUX; every channel free.
+*/
+void dma_init (void)
+{
+    uint8_t ch;
+
+    SIM_SCGC6 |= SIM_SCGC6_DMAMUX_MASK;
+    SIM_SCGC7 |= SIM_SCGC7_DMA_MASK;
+    for (ch = 0; ch != DMA_CHANNELS; ch++) {
+        DMAMUX_CHCFG_REG(DMAMUX0_BASE_PTR, ch) = 0;
+        DMA_DCR_REG(DMA_BASE_PTR, ch) = 0;
+        DMA_DSR_BCR_REG(DMA_BASE_PTR, ch) = DMA_DSR_BCR_DONE_MASK;
+        channels[ch].used = FALSE;
+        channels[ch].desc = NULL;
+        enable_irq(INT_DMA0 + ch);
+    }
+}
+
+/**
+    \brief Take a free channel and route a request source to it.
+    \param source DMA_SRC_x; \ref DMA_SRC_NONE for memory transfers.
+    \return The channel, or -1 when all are taken.
+*/
+int dma_alloc (uint8_t source)
+{
+    uint32_t primask = __irq_save();
+    uint8_t ch;
+
+    for (ch = 0; ch != DMA_CHANNELS; ch++) {
+        if (!channels[ch].used) {
+            channels[ch].used = TRUE;
+            break;
+        }
+    }
+    __irq_restore(primask);
+    if (ch == DMA_CHANNELS)
+        return -1;
+
+    channels[ch].source = source;
+    channels[ch].desc = NULL;
+    DMAMUX_CHCFG_REG(DMAMUX0_BASE_PTR, ch) = 0;             // Change while disabled
+    if (source != DMA_SRC_NONE)
+        DMAMUX_CHCFG_REG(DMAMUX0_BASE_PTR, ch) = DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_SOURCE(source);
+    return ch;
+}
+
+/**
+    \brief Give a channel back, stopping what it runs (no callback).
+*/
+void dma_free (uint8_t ch)
+{
+    if (ch >= DMA_CHANNELS)
+        return;
+    channels[ch].done = NULL;
+    dma_abort(ch);
+    DMAMUX_CHCFG_REG(DMAMUX0_BASE_PTR, ch) = 0;
+    channels[ch].used = FALSE;
+}
+
+/**
+    \brief Start a transfer, or a chain through desc->next.
+    \param done Called from the interrupt once the chain ends or fails;
+    may be NULL.
+    \return DMA_OK, DMA_ERR_CONFIG, or -1 when the channel is busy or
+    not allocated.
+*/
+int dma_start (uint8_t ch, const dma_desc_t *desc, dma_callback_t done, void *arg)
+{
+    channel_t *c;
+    int status;
+
+    if (ch >= DMA_CHANNELS || !channels[ch].used || dma_busy(ch))
+        return -1;
+    c = &channels[ch];
+    c->done = done;
+    c->arg = arg;
+    c->desc = desc;
+    status = load(ch, desc);
+    if (status != DMA_OK)
+        c->desc = NULL;
+    return status;
+}
+
+/**
+    \brief TRUE while a transfer or a chain of the channel runs.
+*/
+uint8_t dma_busy (uint8_t ch)
+{
+    return (ch < DMA_CHANNELS) && (channels[ch].desc != NULL);
+}
+
+/**
+    \brief Stop the channel; the callback gets \ref DMA_ABORTED.
+*/
+void dma_abort (uint8_t ch)
+{
+    uint32_t primask;
+    channel_t *c;
+
+    if (ch >= DMA_CHANNELS)
+        return;
+    c = &channels[ch];
+    primask = __irq_save();
+    DMA_DCR_REG(DMA_BASE_PTR, ch) &= ~DMA_DCR_ERQ_MASK;
+    DMA_DSR_BCR_REG(DMA_BASE_PTR, ch) = DMA_DSR_BCR_DONE_MASK;    // Stops it
+    NVIC_ICPR = 1 << (INT_DMA0 + ch - 16);
+    if (c->desc != NULL) {
+        c->desc = NULL;
+        if (c->done)
+            c->done(ch, DMA_ABORTED, c->arg);
+    }
+    __irq_restore(primask);
+}
+
+/**
+    \brief Channels not allocated.
+*/
+uint8_t dma_free_channels (void)
+{
+    uint8_t ch, n = 0;
+    for (ch = 0; ch != DMA_CHANNELS; ch++)
+        n += !channels[ch].used;
+    return n;
+}
+
+// Widest transfer size that fits the addresses and the count, as flags
+static uint8_t width (uint32_t align)
+{
+    if ((align & 3) == 0)
+        return DMA_WIDTH_32;
+    if ((align & 1) == 0)
+        return DMA_WIDTH_16;
+    return DMA_WIDTH_8;
+}
+
+// Start a copy on the memory channel; FALSE when the CPU has to do it
+static uint8_t copy_dma (const volatile void *src, void *dst, uint8_t flags, uint32_t n,
+    dma_callback_t done, void *arg)
+{
+    // Narrow transfers move less per bus cycle: scale the threshold
+    uint32_t limit = threshold << (2 - ((flags >> 2) & 3));
+
+    if (n < limit || n > DMA_DSR_BCR_BCR_MASK || (threshold >> 30))
+        return FALSE;
+    if (copyCh < 0) {
+        copyCh = dma_alloc(DMA_SRC_NONE);
+        if (copyCh < 0)
+            return FALSE;
+    }
+    if (dma_busy(copyCh))
+        return FALSE;
+    copyDesc.src = src;
+    copyDesc.dst = dst;
+    copyDesc.bytes = n;
+    copyDesc.flags = flags;
+    copyDesc.next = NULL;
+    return dma_start(copyCh, &copyDesc, done, arg) == DMA_OK;
+}
+
+/**
+    \brief Copy memory, by DMA from \ref dma_copy_threshold bytes on.
+    \param done Called once the copy is over, from the DMA interrupt with
+    the channel, or before returning with \ref DMA_COPY_CPU when the CPU
+    made the copy. May be NULL.
+    \return DMA_OK. The buffers must not overlap and must not be touched
+    until the callback.
+*/
+int dma_memcpy_async (void *dst, const void *src, uint32_t n, dma_callback_t done, void *arg)
+{
+    uint8_t flags = width((uint32_t) dst | (uint32_t) src | n);
+
+    if (copy_dma(src, dst, flags | DMA_SRC_INC | DMA_DST_INC, n, done, arg))
+        return DMA_OK;
+    memcpy(dst, src, n);
+    if (done)
+        done(DMA_COPY_CPU, DMA_OK, arg);
+    return DMA_OK;
+}
+
+/**
+    \brief Fill memory, by DMA from \ref dma_copy_threshold bytes on.
+    \param done As in \ref dma_memcpy_async.
+    \return DMA_OK.
+*/
+int dma_memset_async (void *dst, uint8_t value, uint32_t n, dma_callback_t done, void *arg)
+{
+    uint8_t flags = width((uint32_t) dst | n);
+
+    if (copyCh < 0 || !dma_busy(copyCh)) {     // fillWord is free
+        fillWord = value * 0x01010101UL;
+        if (copy_dma(&fillWord, dst, flags | DMA_DST_INC, n, done, arg))
+            return DMA_OK;
+    }
+    memset(dst, value, n);
+    if (done)
+        done(DMA_COPY_CPU, DMA_OK, arg);
+    return DMA_OK;
+}
+
+static volatile uint8_t benchDone;
+
+static void bench_done (uint8_t ch, int status, void *arg)
+{
+    (void) ch; (void) status; (void) arg;
+    benchDone = TRUE;
+}
+
+// Core cycles since a SysTick count, across one reload at most
+static uint32_t elapsed (uint32_t start)
+{
+    uint32_t now = SYST_CVR;
+    return (start >= now) ? start - now : start + SYST_RVR + 1 - now;
+}
+
+/**
+    \brief Time the CPU and the DMA on word aligned copies of 16 to 512
+    bytes and set the threshold to the size from which the DMA is always
+    faster, interrupt included. Needs SysTick running and two free
+    512-byte pool blocks; the default threshold stays otherwise.
+*/
+void dma_copy_calibrate (void)
+{
+    uint32_t *src = pool_alloc(512);
+    uint32_t *dst = pool_alloc(512);
+    uint32_t n, t, cpu, dma, primask, found = 0xFFFFFFFF;
+    uint8_t i, run;
+
+    if (src == NULL || dst == NULL || SYST_RVR == 0)
+        goto out;
+
+    threshold = 0;                                  // Force the DMA path
+    for (i = 0, n = 16; i != BENCH_SIZES; i++, n <<= 1) {
+        cpu = dma = 0xFFFFFFFF;
+        for (run = 0; run != BENCH_RUNS; run++) {
+            primask = __irq_save();
+            t = SYST_CVR;
+            memcpy(dst, src, n);
+            t = elapsed(t);
+            __irq_restore(primask);
+            if (t < cpu)
+                cpu = t;
+
+            benchDone = FALSE;
+            t = SYST_CVR;
+            dma_memcpy_async(dst, src, n, bench_done, NULL);
+            while (!benchDone)
+                ;
+            t = elapsed(t);
+            if (t < dma)
+                dma = t;
+        }
+        benchCpu[i] = cpu;
+        benchDma[i] = dma;
+        if (dma >= cpu)
+            found = 0xFFFFFFFF;                     // Not yet from here on
+        else if (found == 0xFFFFFFFF)
+            found = n;
+    }
+    threshold = found;
+
+out:
+    if (src) pool_free(src);
+    if (dst) pool_free(dst);
+}
+
+/**
+    \brief Bytes from which a word aligned copy goes to DMA; above 1 GB
+    when the DMA never won.
+*/
+uint32_t dma_copy_threshold (void)
+{
+    return threshold;
+}
+
+/**
+    \brief Print the channels and the copy benchmark on the console.
+*/
+void dma_print (void)
+{
+    uint32_t n;
+    uint8_t i;
+
+    iprintf("  free channels %u\r\n", dma_free_channels());
+    if (threshold >> 30)
+        iprintf("  copy threshold off\r\n");
+    else
+        iprintf("  copy threshold %lu B\r\n", (unsigned long) threshold);
+    if (benchCpu[0] == 0)
+        return;
+    iprintf("  bytes   cpu   dma\r\n");
+    for (i = 0, n = 16; i != BENCH_SIZES; i++, n <<= 1)
+        iprintf("  %5lu %5u %5u\r\n", (unsigned long) n, benchCpu[i], benchDma[i]);
+}
@@ -0,0 +1,84 @@
+/**
+    \file dma.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief DMA service: the four channels of the DMA controller are
+    allocated to drivers on request, routed through the DMAMUX, and
+    report the end of a transfer (or of a chain of them) by callback.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _DMA_H_
+#define _DMA_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup DMA
+    @{
+*/
+
+#define DMA_CHANNELS        4       /**< Channels of the controller.            */
+
+/* DMAMUX request sources (reference manual, DMA request sources) */
+#define DMA_SRC_NONE        0       /**< Memory to memory, software start.      */
+#define DMA_SRC_UART0_RX    2
+#define DMA_SRC_UART0_TX    3
+#define DMA_SRC_SPI0_RX     16
+#define DMA_SRC_SPI0_TX     17
+#define DMA_SRC_ADC0        40
+#define DMA_SRC_TPM0_OVF    54
+#define DMA_SRC_ALWAYS      60      /**< Always requesting: paced by software.  */
+
+/* Descriptor flags */
+#define DMA_SRC_INC         0x01    /**< Source address advances.               */
+#define DMA_DST_INC         0x02    /**< Destination address advances.          */
+#define DMA_WIDTH_8         0x00    /**< Transfer size, both sides.             */
+#define DMA_WIDTH_16        0x04
+#define DMA_WIDTH_32        0x08
+
+/* Completion status */
+#define DMA_OK              0
+#define DMA_ERR_CONFIG      -1      /**< Size, alignment or count refused.      */
+#define DMA_ERR_SOURCE      -2      /**< Bus error on the source side.          */
+#define DMA_ERR_DEST        -3      /**< Bus error on the destination side.     */
+#define DMA_ABORTED         -4
+
+/**
+    \brief One transfer. The descriptor must stay valid until the
+    callback: a chain is followed from the interrupt handler.
+*/
+typedef struct dma_desc {
+    const volatile void *src;
+    volatile void       *dst;
+    uint32_t            bytes;      /**< Multiple of the width, below 1 MB.     */
+    uint8_t             flags;      /**< DMA_SRC_INC, DMA_DST_INC, DMA_WIDTH_x. */
+    const struct dma_desc *next;    /**< Started when this one ends, or NULL.   */
+} dma_desc_t;
+
+typedef void (*dma_callback_t) (uint8_t ch, int status, void *arg);
+
+#define DMA_COPY_THRESHOLD  64      /**< Bytes from which a word copy goes to
+                                         DMA, until \ref dma_copy_calibrate.  */
+#define DMA_COPY_CPU        DMA_CHANNELS    /**< Channel of a CPU copy.         */
+
+void dma_init (void);
+int dma_alloc (uint8_t source);
+void dma_free (uint8_t ch);
+int dma_start (uint8_t ch, const dma_desc_t *desc, dma_callback_t done, void *arg);
+uint8_t dma_busy (uint8_t ch);
+void dma_abort (uint8_t ch);
+uint8_t dma_free_channels (void);
+
+int dma_memcpy_async (void *dst, const void *src, uint32_t n, dma_callback_t done, void *arg);
+int dma_memset_async (void *dst, uint8_t value, uint32_t n, dma_callback_t done, void *arg);
+void dma_copy_calibrate (void);
+uint32_t dma_copy_threshold (void);
+void dma_print (void);
+
+/** @} */ // DMA
+
+#endif  // _DMA_H_
@@ -0,0 +1,512 @@
+/**
+    \file dsp.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Fixed-point DSP kernels for the Cortex-M0+.
+    \note Cycle counts are estimated from the instruction sequence that
+    arm-none-eabi-gcc -Os emits for the M0+ (single-cycle MULS, 2-cycle
+    loads and stores, 2 cycles per taken branch):
+    - FIR: ~9 cycles/tap (4 taps per iteration) + ~40 per sample.
+    - Biquad: ~45 cycles per stage and sample.
+    - Moving RMS: ~30 cycles per update, ~200 per read (square root).
+    - Goertzel: ~14 cycles per sample.
+    - Real FFT 256 points: ~110k cycles (2.3 ms at 48 MHz).
+    - Q31 FIR: ~45 cycles/tap; Q31 biquad: ~230 cycles per stage and
+      sample. Every 32x32->64 product is a call to __aeabi_lmul.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <string.h>
+#include "dsp.h"
+
+/**
+    \brief sin(2.pi.i/256) for the first quarter of the circle, Q15.
+    The remaining quarters follow from symmetry.
+*/
+static const q15_t sine_quarter[65] = {
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+/** \brief sin(2.pi.i/256) for any i, Q15. */
+static inline int32_t sin_index (uint8_t i)
+{
+    uint8_t q = i & 63;
+    switch (i >> 6) {
+        case 0:  return  sine_quarter[q];
+        case 1:  return  sine_quarter[64 - q];
+        case 2:  return -sine_quarter[q];
+        default: return -sine_quarter[64 - q];
+    }
+}
+
+/** \brief Saturate a 64-bit accumulator shifted down to Q15. */
+static inline q15_t sat_acc (int64_t acc, uint8_t shift)
+{
+    acc >>= shift;
+    if (acc > INT16_MAX) return INT16_MAX;
+    if (acc < INT16_MIN) return INT16_MIN;
+    return (q15_t) acc;
+}
+
+/** \brief Saturate a 64-bit accumulator shifted down to Q31. */
+static inline q31_t sat_acc31 (int64_t acc, uint8_t shift)
+{
+    acc >>= shift;
+    if (acc > INT32_MAX) return INT32_MAX;
+    if (acc < INT32_MIN) return INT32_MIN;
+    return (q31_t) acc;
+}
+
+// -----------------------------------------------------------------------------
+// FIR
+
+/**
+    \brief Initialize a FIR filter and clear its delay line.
+    \param f Filter instance.
+    \param coeffs Coefficients in Q15, b[0] (newest sample) first.
+    \param state Buffer of 2 * taps samples.
+    \param taps Number of coefficients.
+*/
+void dsp_fir_q15_init (dsp_fir_q15_t *f, const q15_t *coeffs, q15_t *state, uint16_t taps)
+{
+    f->coeffs = coeffs;
+    f->state = state;
+    f->taps = taps;
+    f->pos = 0;
+    memset(state, 0, 2 * taps * sizeof(q15_t));
+}
+
+/**
+    \brief Filter one sample.
+    \param f Filter instance.
+    \param x Input sample.
+    \return Output sample, saturated.
+*/
+q15_t dsp_fir_q15 (dsp_fir_q15_t *f, q15_t x)
+{
+    const q15_t *c = f->coeffs;
+    const q15_t *s;
+    uint16_t k = f->taps;
+    int64_t acc = 0;
+
+    // Newest sample goes to both copies; the window starts on it
+    f->state[f->pos] = x;
+    f->state[f->pos + k] = x;
+    s = f->state + f->pos;
+
+    while (k >= 4) {
+        acc += (int32_t) c[0] * s[0];
+        acc += (int32_t) c[1] * s[1];
+        acc += (int32_t) c[2] * s[2];
+        acc += (int32_t) c[3] * s[3];
+        c += 4;
+        s += 4;
+        k -= 4;
+    }
+    while (k--) {
+        acc += (int32_t) *c++ * *s++;
+    }
+
+    f->pos = (f->pos == 0) ? f->taps - 1 : f->pos - 1;
+    return sat_acc(acc, 15);
+}
+
+/**
+    \brief Filter a block of samples (in and out may be the same buffer).
+*/
+void dsp_fir_q15_block (dsp_fir_q15_t *f, const q15_t *in, q15_t *out, uint16_t n)
+{
+    while (n--) {
+        *out++ = dsp_fir_q15(f, *in++);
+    }
+}
+
+/**
+    \brief Initialize a Q31 FIR filter, as \ref dsp_fir_q15_init.
+*/
+void dsp_fir_q31_init (dsp_fir_q31_t *f, const q31_t *coeffs, q31_t *state, uint16_t taps)
+{
+    f->coeffs = coeffs;
+    f->state = state;
+    f->taps = taps;
+    f->pos = 0;
+    memset(state, 0, 2 * taps * sizeof(q31_t));
+}
+
+/**
+    \brief Filter one Q31 sample.
+    \return Output sample, saturated.
+*/
+q31_t dsp_fir_q31 (dsp_fir_q31_t *f, q31_t x)
+{
+    const q31_t *c = f->coeffs;
+    const q31_t *s;
+    uint16_t k = f->taps;
+    int64_t acc = 0;
+
+    f->state[f->pos] = x;
+    f->state[f->pos + k] = x;
+    s = f->state + f->pos;
+
+    while (k >= 2) {
+        acc += (int64_t) c[0] * s[0];
+        acc += (int64_t) c[1] * s[1];
+        c += 2;
+        s += 2;
+        k -= 2;
+    }
+    if (k) {
+        acc += (int64_t) *c * *s;
+    }
+
+    f->pos = (f->pos == 0) ? f->taps - 1 : f->pos - 1;
+    return sat_acc31(acc, 31);
+}
+
+// -----------------------------------------------------------------------------
+// Biquad cascade
+
+/**
+    \brief Initialize a biquad cascade and clear its state.
+    \param f Filter instance.
+    \param coeffs 5 coefficients per stage, see \ref DSP_Biquad.
+    \param state Buffer of 4 samples per stage.
+    \param stages Number of second order sections.
+    \param postShift Coefficient headroom in bits (Q(15 - postShift)).
+*/
+void dsp_biquad_q15_init (dsp_biquad_q15_t *f, const q15_t *coeffs, q15_t *state, uint8_t stages, uint8_t postShift)
+{
+    f->coeffs = coeffs;
+    f->state = state;
+    f->stages = stages;
+    f->postShift = postShift;
+    memset(state, 0, 4 * stages * sizeof(q15_t));
+}
+
+/**
+    \brief Filter one sample through every stage of the cascade.
+*/
+q15_t dsp_biquad_q15 (dsp_biquad_q15_t *f, q15_t x)
+{
+    const q15_t *c = f->coeffs;
+    q15_t *st = f->state;
+    uint8_t n = f->stages;
+    uint8_t shift = 15 - f->postShift;
+    int64_t acc;
+    q15_t y;
+
+    while (n--) {
+        acc  = (int32_t) c[0] * x;
+        acc += (int32_t) c[1] * st[0];
+        acc += (int32_t) c[2] * st[1];
+        acc += (int32_t) c[3] * st[2];
+        acc += (int32_t) c[4] * st[3];
+        y = sat_acc(acc, shift);
+
+        st[1] = st[0];
+        st[0] = x;
+        st[3] = st[2];
+        st[2] = y;
+
+        x = y;
+        c += 5;
+        st += 4;
+    }
+    return x;
+}
+
+/**
+    \brief Initialize a Q31 biquad cascade, as \ref dsp_biquad_q15_init.
+*/
+void dsp_biquad_q31_init (dsp_biquad_q31_t *f, const q31_t *coeffs, q31_t *state, uint8_t stages, uint8_t postShift)
+{
+    f->coeffs = coeffs;
+    f->state = state;
+    f->stages = stages;
+    f->postShift = postShift;
+    memset(state, 0, 4 * stages * sizeof(q31_t));
+}
+
+/**
+    \brief Filter one Q31 sample through every stage of the cascade.
+*/
+q31_t dsp_biquad_q31 (dsp_biquad_q31_t *f, q31_t x)
+{
+    const q31_t *c = f->coeffs;
+    q31_t *st = f->state;
+    uint8_t n = f->stages;
+    uint8_t shift = 31 - f->postShift;
+    int64_t acc;
+    q31_t y;
+
+    while (n--) {
+        acc  = (int64_t) c[0] * x;
+        acc += (int64_t) c[1] * st[0];
+        acc += (int64_t) c[2] * st[1];
+        acc += (int64_t) c[3] * st[2];
+        acc += (int64_t) c[4] * st[3];
+        y = sat_acc31(acc, shift);
+
+        st[1] = st[0];
+        st[0] = x;
+        st[3] = st[2];
+        st[2] = y;
+
+        x = y;
+        c += 5;
+        st += 4;
+    }
+    return x;
+}
+
+// -----------------------------------------------------------------------------
+// Moving RMS
+
+/**
+    \brief Initialize a moving RMS over 2^log2len samples.
+*/
+void dsp_rms_q15_init (dsp_rms_q15_t *r, q15_t *window, uint8_t log2len)
+{
+    r->window = window;
+    r->sum = 0;
+    r->pos = 0;
+    r->log2len = log2len;
+    memset(window, 0, (1 << log2len) * sizeof(q15_t));
+}
+
+/**
+    \brief Push one sample into the window.
+*/
+void dsp_rms_q15_update (dsp_rms_q15_t *r, q15_t x)
+{
+    int32_t old = r->window[r->pos];
+    r->sum -= (uint32_t)(old * old);
+    r->sum += (uint32_t)((int32_t) x * x);
+    r->window[r->pos] = x;
+    r->pos = (r->pos + 1) & ((1 << r->log2len) - 1);
+}
+
+/** \brief Bitwise integer square root, 16 iterations, no divide. */
+static uint32_t isqrt32 (uint32_t x)
+{
+    uint32_t root = 0, bit = 1UL << 30;
+
+    while (bit > x)
+        bit >>= 2;
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+    \brief Current RMS value of the window.
+    \return RMS in Q15.
+*/
+q15_t dsp_rms_q15 (const dsp_rms_q15_t *r)
+{
+    uint32_t root = isqrt32((uint32_t)(r->sum >> r->log2len));  // Q30 -> Q15
+    return (root > INT16_MAX) ? INT16_MAX : (q15_t) root;
+}
+
+// -----------------------------------------------------------------------------
+// Goertzel
+
+/**
+    \brief Coefficient for the bin closest to a frequency.
+    \param freq Frequency to detect, Hz.
+    \param fs Sample rate, Hz.
+    \param n Block length in samples.
+    \return 2.cos(2.pi.k/n) in Q14.
+    \note Uses two divides; meant for initialization only.
+*/
+q15_t dsp_goertzel_coeff (uint32_t freq, uint32_t fs, uint16_t n)
+{
+    uint32_t k = (freq * n + fs / 2) / fs;
+    uint16_t phase = (uint16_t)((k << 16) / n);
+
+    // 2.cos() in Q14 has the same representation as cos() in Q15
+    return dsp_sin_q15(phase + 0x4000);
+}
+
+/**
+    \brief Clear the state before a new block.
+*/
+void dsp_goertzel_q15_reset (dsp_goertzel_q15_t *g)
+{
+    g->s1 = 0;
+    g->s2 = 0;
+}
+
+/**
+    \brief Feed a block of samples.
+*/
+void dsp_goertzel_q15_block (dsp_goertzel_q15_t *g, const q15_t *in, uint16_t n)
+{
+    while (n >= 2) {
+        dsp_goertzel_q15(g, in[0]);
+        dsp_goertzel_q15(g, in[1]);
+        in += 2;
+        n -= 2;
+    }
+    if (n) {
+        dsp_goertzel_q15(g, *in);
+    }
+}
+
+static inline int32_t clamp14 (int32_t x)
+{
+    if (x > 16383) return 16383;
+    if (x < -16383) return -16383;
+    return x;
+}
+
+/**
+    \brief Squared magnitude of the bin at the end of a block.
+    \param g Filter instance.
+    \param shift Right shift applied to the state before squaring. It
+    must bring the state below 2^14 (e.g. 8 for 64-sample blocks of
+    full-scale input); larger values are clamped.
+    \return |X(k)|^2 / 2^(2.shift).
+*/
+uint32_t dsp_goertzel_q15_power (const dsp_goertzel_q15_t *g, uint8_t shift)
+{
+    int32_t a = clamp14(g->s1 >> shift);
+    int32_t b = clamp14(g->s2 >> shift);
+    int32_t p = a * a + b * b - (((int32_t) g->coeff * a) >> 14) * b;
+    return (p < 0) ? 0 : (uint32_t) p;
+}
+
+// -----------------------------------------------------------------------------
+// FFT
+
+/**
+    \brief Sine with linear interpolation.
+    \param phase Angle in 1/65536 of a turn.
+    \return sin(2.pi.phase/65536) in Q15.
+*/
+q15_t dsp_sin_q15 (uint16_t phase)
+{
+    uint8_t i = phase >> 8;
+    int32_t frac = phase & 0xFF;
+    int32_t a = sin_index(i);
+    int32_t b = sin_index((uint8_t)(i + 1));
+    return (q15_t)(a + (((b - a) * frac) >> 8));
+}
+
+/**
+    \brief In-place complex FFT.
+    \param buf m complex samples, interleaved {re, im}.
+    \param m Number of points, power of two up to \ref DSP_FFT_MAX.
+    \note Output is X/m in natural order.
+*/
+void dsp_cfft_q15 (q15_t *buf, uint16_t m)
+{
+    uint16_t i, j, k, len, half, bit;
+    uint16_t step = DSP_FFT_MAX / 2;
+    q15_t t;
+
+    // Bit reversal permutation
+    for (i = 1, j = 0; i < m; i++) {
+        for (bit = m >> 1; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            t = buf[2*i];   buf[2*i]   = buf[2*j];   buf[2*j]   = t;
+            t = buf[2*i+1]; buf[2*i+1] = buf[2*j+1]; buf[2*j+1] = t;
+        }
+    }
+
+    // Butterflies, halving on every stage
+    for (len = 2; len <= m; len <<= 1, step >>= 1) {
+        half = len >> 1;
+        for (k = 0; k < half; k++) {
+            uint8_t idx = (uint8_t)(k * step);
+            int32_t wr =  sin_index(idx + 64);      // cos
+            int32_t wi = -sin_index(idx);           // -sin, forward transform
+            for (i = k; i < m; i += len) {
+                q15_t *a = buf + 2 * i;
+                q15_t *b = a + 2 * half;
+                int32_t tr = (wr * b[0] - wi * b[1]) >> 15;
+                int32_t ti = (wr * b[1] + wi * b[0]) >> 15;
+                b[0] = dsp_sat_q15((a[0] - tr) >> 1);
+                b[1] = dsp_sat_q15((a[1] - ti) >> 1);
+                a[0] = dsp_sat_q15((a[0] + tr) >> 1);
+                a[1] = dsp_sat_q15((a[1] + ti) >> 1);
+            }
+        }
+    }
+}
+
+/**
+    \brief In-place real FFT, computed as an n/2 complex FFT plus a split
+    pass.
+    \param buf n real samples on input. On output, bins 1..n/2-1 as
+    interleaved {re, im}; buf[0] holds bin 0 and buf[1] bin n/2 (both
+    real).
+    \param n Number of points, power of two from 4 up to \ref DSP_FFT_MAX.
+    \note Output is X/n.
+*/
+void dsp_rfft_q15 (q15_t *buf, uint16_t n)
+{
+    uint16_t m = n >> 1;
+    uint16_t k;
+    uint8_t step = (uint8_t)(DSP_FFT_MAX / n);      // Constant divide, done once
+    int32_t zr, zi, cr, ci;
+
+    dsp_cfft_q15(buf, m);
+
+    zr = buf[0];
+    zi = buf[1];
+    buf[0] = (q15_t)((zr + zi) >> 1);
+    buf[1] = (q15_t)((zr - zi) >> 1);
+
+    for (k = 1; k <= m / 2; k++) {
+        q15_t *p = buf + 2 * k;
+        q15_t *q = buf + 2 * (m - k);
+        uint8_t idx = (uint8_t)(k * step);
+        int32_t wr =  sin_index(idx + 64);
+        int32_t wi = -sin_index(idx);
+        int32_t fer, fei, forr, foi, xr, xi, yr, yi;
+
+        zr = p[0]; zi = p[1];
+        cr = q[0]; ci = q[1];
+
+        // X[k] = Fe + W^k.Fo, with Fe = (Z[k] + Z*[m-k]) / 2 and
+        // Fo = -j.(Z[k] - Z*[m-k]) / 2
+        fer  = (zr + cr) >> 1;
+        fei  = (zi - ci) >> 1;
+        forr = (zi + ci) >> 1;
+        foi  = (cr - zr) >> 1;
+        xr = (fer + ((wr * forr - wi * foi) >> 15)) >> 1;
+        xi = (fei + ((wr * foi + wi * forr) >> 15)) >> 1;
+
+        // X[m-k] uses the mirrored pair and W^(m-k) = -conj(W^k)
+        fei  = -fei;
+        foi  = -foi;
+        yr = (fer + ((-wr * forr - wi * foi) >> 15)) >> 1;
+        yi = (fei + ((-wr * foi + wi * forr) >> 15)) >> 1;
+
+        p[0] = dsp_sat_q15(xr);
+        p[1] = dsp_sat_q15(xi);
+        q[0] = dsp_sat_q15(yr);
+        q[1] = dsp_sat_q15(yi);
+    }
+}
@@ -0,0 +1,166 @@
+/**
+    \file dsp.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Fixed-point DSP kernels (Q15 data, Q31 accumulators) for the
+    Cortex-M0+: no divide, no DSP extension and no FPU are assumed, only
+    the single-cycle 32x32->32 multiplier of the KL25Z. FIR and biquad
+    also come in Q31, for filters whose state needs more than 16 bits.
+    \note RMS, Goertzel and FFT are Q15 only: their input is the 16-bit
+    ADC, and Q31 versions would pay a 64-bit multiply per step.
+    \note Host tests: make check (tools/dsptest.c).
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _DSP_H_
+#define _DSP_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup DSP
+    @{
+*/
+
+typedef int16_t q15_t;      /**< 1.15 fixed point, [-1, 1).   */
+typedef int32_t q31_t;      /**< 1.31 fixed point, [-1, 1).   */
+
+#define Q15(x)  ((q15_t)((x) * 32767.0 + ((x) < 0 ? -0.5 : 0.5)))  /**< Constant to Q15. */
+
+/** \brief Saturate a 32-bit value to the Q15 range. */
+static inline q15_t dsp_sat_q15 (int32_t x)
+{
+    if (x > INT16_MAX) return INT16_MAX;
+    if (x < INT16_MIN) return INT16_MIN;
+    return (q15_t) x;
+}
+
+/**
+    \addtogroup DSP_FIR FIR filter
+    \brief Direct form FIR with circular state. The state buffer holds
+    two copies of the delay line (2 x taps samples) so the dot product
+    always runs over a contiguous window without wrap checks.
+    @{
+*/
+typedef struct {
+    const q15_t *coeffs;    /**< taps coefficients, b[0] first.     */
+    q15_t       *state;     /**< 2 * taps samples.                  */
+    uint16_t    taps;
+    uint16_t    pos;
+} dsp_fir_q15_t;
+
+void dsp_fir_q15_init (dsp_fir_q15_t *f, const q15_t *coeffs, q15_t *state, uint16_t taps);
+q15_t dsp_fir_q15 (dsp_fir_q15_t *f, q15_t x);
+void dsp_fir_q15_block (dsp_fir_q15_t *f, const q15_t *in, q15_t *out, uint16_t n);
+
+/** \brief Q31 FIR: no overflow while the sum of |b| stays below 2. */
+typedef struct {
+    const q31_t *coeffs;    /**< taps coefficients, b[0] first.     */
+    q31_t       *state;     /**< 2 * taps samples.                  */
+    uint16_t    taps;
+    uint16_t    pos;
+} dsp_fir_q31_t;
+
+void dsp_fir_q31_init (dsp_fir_q31_t *f, const q31_t *coeffs, q31_t *state, uint16_t taps);
+q31_t dsp_fir_q31 (dsp_fir_q31_t *f, q31_t x);
+/** @} */
+
+/**
+    \addtogroup DSP_Biquad Biquad cascade
+    \brief Direct form I second order sections. Coefficients per stage
+    are {b0, b1, b2, a1, a2} in Q(15 - postShift), with the feedback
+    terms already negated: y = b0.x0 + b1.x1 + b2.x2 + a1.y1 + a2.y2.
+    @{
+*/
+typedef struct {
+    const q15_t *coeffs;    /**< 5 coefficients per stage.          */
+    q15_t       *state;     /**< 4 samples per stage {x1,x2,y1,y2}. */
+    uint8_t     stages;
+    uint8_t     postShift;  /**< 1 allows coefficients in [-2, 2).  */
+} dsp_biquad_q15_t;
+
+void dsp_biquad_q15_init (dsp_biquad_q15_t *f, const q15_t *coeffs, q15_t *state, uint8_t stages, uint8_t postShift);
+q15_t dsp_biquad_q15 (dsp_biquad_q15_t *f, q15_t x);
+
+/**
+    \brief Q31 biquad cascade, same layout: no overflow while the sum of
+    the five |coefficients| of a stage stays below 4.
+*/
+typedef struct {
+    const q31_t *coeffs;    /**< 5 coefficients per stage.          */
+    q31_t       *state;     /**< 4 samples per stage {x1,x2,y1,y2}. */
+    uint8_t     stages;
+    uint8_t     postShift;  /**< 1 allows coefficients in [-2, 2).  */
+} dsp_biquad_q31_t;
+
+void dsp_biquad_q31_init (dsp_biquad_q31_t *f, const q31_t *coeffs, q31_t *state, uint8_t stages, uint8_t postShift);
+q31_t dsp_biquad_q31 (dsp_biquad_q31_t *f, q31_t x);
+/** @} */
+
+/**
+    \addtogroup DSP_RMS Moving RMS
+    \brief RMS over the last 2^log2len samples. The update is O(1), the
+    square root is only taken when the value is read.
+    @{
+*/
+typedef struct {
+    q15_t    *window;       /**< 2^log2len samples.                 */
+    uint64_t sum;           /**< Sum of squares, Q30.               */
+    uint16_t pos;
+    uint8_t  log2len;
+} dsp_rms_q15_t;
+
+void dsp_rms_q15_init (dsp_rms_q15_t *r, q15_t *window, uint8_t log2len);
+void dsp_rms_q15_update (dsp_rms_q15_t *r, q15_t x);
+q15_t dsp_rms_q15 (const dsp_rms_q15_t *r);
+/** @} */
+
+/**
+    \addtogroup DSP_Goertzel Goertzel
+    \brief Single bin DFT. The coefficient is 2.cos(w) in Q14. The
+    state stays below 2^28 for Q15 input and blocks up to 256 samples.
+    @{
+*/
+typedef struct {
+    q15_t coeff;            /**< 2.cos(2.pi.k/N), Q14.              */
+    q31_t s1;
+    q31_t s2;
+} dsp_goertzel_q15_t;
+
+q15_t dsp_goertzel_coeff (uint32_t freq, uint32_t fs, uint16_t n);
+void dsp_goertzel_q15_reset (dsp_goertzel_q15_t *g);
+void dsp_goertzel_q15_block (dsp_goertzel_q15_t *g, const q15_t *in, uint16_t n);
+uint32_t dsp_goertzel_q15_power (const dsp_goertzel_q15_t *g, uint8_t shift);
+
+/** \brief Feed one sample (Q15) into a Goertzel filter. */
+static inline void dsp_goertzel_q15 (dsp_goertzel_q15_t *g, q15_t x)
+{
+    // coeff.s1 is a 16x32 product: split s1 so that both halves fit
+    // the 32-bit multiplier
+    int32_t hi = (int32_t) g->coeff * (g->s1 >> 16);
+    int32_t lo = (int32_t) g->coeff * (int32_t)(g->s1 & 0xFFFF);
+    q31_t s0 = x + hi * 4 + (lo >> 14) - g->s2;
+    g->s2 = g->s1;
+    g->s1 = s0;
+}
+/** @} */
+
+/**
+    \addtogroup DSP_FFT FFT
+    \brief Radix-2 FFT with 1/2 scaling per stage, so the output never
+    overflows: the complex FFT returns X/M and the real FFT X/N.
+    @{
+*/
+#define DSP_FFT_MAX 256     /**< Largest real FFT (sine table resolution). */
+
+q15_t dsp_sin_q15 (uint16_t phase);
+void dsp_cfft_q15 (q15_t *buf, uint16_t m);
+void dsp_rfft_q15 (q15_t *buf, uint16_t n);
+/** @} */
+
+/** @} */ // DSP
+
+#endif  // _DSP_H_
@@ -0,0 +1,147 @@
+/**
+    \file fmt.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Integer-only formatter. Decimal conversion subtracts powers of
+    ten (no divide on the M0+): one step per unit of each digit, so the
+    cost follows the digit sum, 84 steps at most (3999999999). There is
+    no format string to parse and a few words of stack.
+    \note tools/fmtbench checks the menu and monitor lines against
+    snprintf and times both on the host.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "console.h"
+#include "fmt.h"
+
+static const uint32_t pow10[] = {
+    1000000000, 100000000, 10000000, 1000000, 100000,
+    10000, 1000, 100, 10, 1
+};
+
+/**
+    \brief Start an empty buffer.
+*/
+void fmt_init (fmt_t *f, char *buf, uint16_t size)
+{
+    f->buf = buf;
+    f->size = size;
+    f->len = 0;
+    f->console = TRUE;
+}
+
+/**
+    \brief Start an empty buffer that is never sent: text beyond its
+    size is dropped.
+*/
+void fmt_init_string (fmt_t *f, char *buf, uint16_t size)
+{
+    fmt_init(f, buf, size);
+    f->console = FALSE;
+}
+
+/**
+    \brief Send the buffered text with a single console write.
+*/
+void fmt_flush (fmt_t *f)
+{
+    if (f->len && f->console) {
+        fflush(stdout);                 // Keep order with pending iprintf text
+        console_write(f->buf, f->len);
+    }
+    f->len = 0;
+}
+
+void fmt_char (fmt_t *f, char c)
+{
+    if (f->len == f->size) {
+        if (!f->console)
+            return;
+        fmt_flush(f);
+    }
+    f->buf[f->len++] = c;
+}
+
+void fmt_str (fmt_t *f, const char *s)
+{
+    while (*s)
+        fmt_char(f, *s++);
+}
+
+/**
+    \brief Digits of v, most significant first, into d; returns the
+    count (at least one).
+*/
+static uint8_t digits (uint32_t v, char *d)
+{
+    uint8_t i, n = 0;
+
+    for (i = 0; i != sizeof(pow10) / sizeof(pow10[0]); i++) {
+        char c = '0';
+        while (v >= pow10[i]) {
+            v -= pow10[i];
+            c++;
+        }
+        if (c != '0' || n || i == sizeof(pow10) / sizeof(pow10[0]) - 1)
+            d[n++] = c;
+    }
+    return n;
+}
+
+static void field (fmt_t *f, const char *d, uint8_t n, uint8_t width, char pad, char sign)
+{
+    uint8_t used = n + (sign != 0);
+
+    // Zero padding goes after the sign, space padding before it
+    if (sign && pad == '0')
+        fmt_char(f, sign);
+    while (used < width) {
+        fmt_char(f, pad);
+        used++;
+    }
+    if (sign && pad != '0')
+        fmt_char(f, sign);
+    while (n--)
+        fmt_char(f, *d++);
+}
+
+/**
+    \brief Unsigned decimal.
+    \param width Minimum field width, 0 for none.
+    \param pad ' ' or '0'.
+*/
+void fmt_u32 (fmt_t *f, uint32_t v, uint8_t width, char pad)
+{
+    char d[10];
+    field(f, d, digits(v, d), width, pad, 0);
+}
+
+/**
+    \brief Signed decimal, see \ref fmt_u32.
+*/
+void fmt_i32 (fmt_t *f, int32_t v, uint8_t width, char pad)
+{
+    char d[10];
+    uint32_t u = (v < 0) ? -(uint32_t) v : (uint32_t) v;
+    field(f, d, digits(u, d), width, pad, (v < 0) ? '-' : 0);
+}
+
+/**
+    \brief Hexadecimal with "0x" prefix.
+    \param digits Minimum number of digits (1 to 8).
+*/
+void fmt_hex (fmt_t *f, uint32_t v, uint8_t digits)
+{
+    int8_t i = 7;
+
+    while (i >= digits && (v >> (4 * i)) == 0)
+        i--;
+    fmt_str(f, "0x");
+    for (; i >= 0; i--)
+        fmt_char(f, "0123456789abcdef"[(v >> (4 * i)) & 0xF]);
+}
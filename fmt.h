@@ -0,0 +1,43 @@
+/**
+    \file fmt.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Integer-only text formatting into a caller buffer. Output is
+    written to the console in whole buffers: a full buffer is flushed
+    on its own, fmt_flush() sends the rest.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _FMT_H_
+#define _FMT_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Fmt
+    @{
+*/
+
+/** \brief Output buffer and fill level. */
+typedef struct {
+    char     *buf;
+    uint16_t size;
+    uint16_t len;
+    uint8_t  console;           /**< Flush to the console when full, else truncate. */
+} fmt_t;
+
+void fmt_init (fmt_t *f, char *buf, uint16_t size);
+void fmt_init_string (fmt_t *f, char *buf, uint16_t size);
+void fmt_char (fmt_t *f, char c);
+void fmt_str (fmt_t *f, const char *s);
+void fmt_u32 (fmt_t *f, uint32_t v, uint8_t width, char pad);
+void fmt_i32 (fmt_t *f, int32_t v, uint8_t width, char pad);
+void fmt_hex (fmt_t *f, uint32_t v, uint8_t digits);
+void fmt_flush (fmt_t *f);
+
+/** @} */ // Fmt
+
+#endif  // _FMT_H_
@@ -0,0 +1,159 @@
+/**
+    \file gesture.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Touch gesture recognizer. Every decision is taken from the
+    stamps of the touch events; the current time is only needed to close
+    the gestures defined by the absence of an event (a tap that is not
+    followed by a second one, a hold, the auto-repeat).
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include "freedom.h"
+#include "common.h"
+#include "touch.h"
+#include "gesture.h"
+
+enum {
+    stIdle,
+    stPressed,                      // Down, not yet a hold or a swipe
+    stHeld,                         // Hold emitted, auto-repeat running
+    stSwiped,                       // Travel reached, swipe on release
+    stTapped,                       // Released as a tap, waiting the gap
+    stSecond                        // Double-tap emitted, waiting release
+};
+
+#define QUEUE_LEN   4               // Power of two
+
+static gesture_t queue[QUEUE_LEN];
+static uint8_t head, tail;
+static uint8_t state;
+static uint8_t downPos;
+static uint32_t since;              // Stamp of the last transition
+static uint32_t nextRepeat;
+
+// Ticks from a to b; signed, since an event raised while the caller was
+// reading sysTicks can carry a stamp one tick ahead of 'now'
+static inline int32_t elapsed (uint32_t a, uint32_t b)
+{
+    return (int32_t)(b - a);
+}
+
+static void emit (uint8_t type, uint32_t stamp)
+{
+    if ((uint8_t)(head - tail) == QUEUE_LEN)
+        return;                     // Reader is behind: drop the newest
+    queue[head & (QUEUE_LEN - 1)].stamp = stamp;
+    queue[head & (QUEUE_LEN - 1)].type  = type;
+    queue[head & (QUEUE_LEN - 1)].pos   = downPos;
+    head++;
+}
+
+/**
+    \brief Run the state machine for one touch event.
+*/
+static void on_touch (const touch_event_t *ev)
+{
+    switch (state) {
+        case stIdle:
+            if (ev->type == touchDown) {
+                downPos = ev->pos;
+                since = ev->stamp;
+                state = stPressed;
+            }
+            break;
+        case stPressed:
+            if (ev->type == touchMove) {
+                if (ev->pos >= downPos + GESTURE_SWIPE ||
+                    ev->pos + GESTURE_SWIPE <= downPos) {
+                    state = stSwiped;
+                }
+            }
+            else if (ev->type == touchUp) {
+                if (elapsed(since, ev->stamp) <= GESTURE_TAP_MAX) {
+                    since = ev->stamp;
+                    state = stTapped;
+                }
+                else {
+                    state = stIdle;     // Too long for a tap, too short for a hold
+                }
+            }
+            break;
+        case stSwiped:
+            if (ev->type == touchUp) {
+                emit((ev->pos > downPos) ? gestureSwipeUp : gestureSwipeDown, ev->stamp);
+                state = stIdle;
+            }
+            break;
+        case stTapped:
+            if (ev->type == touchDown) {
+                if (elapsed(since, ev->stamp) <= GESTURE_DOUBLE_GAP) {
+                    emit(gestureDoubleTap, ev->stamp);
+                    state = stSecond;
+                    break;
+                }
+                emit(gestureTap, since);    // Gap expired before we looked
+                downPos = ev->pos;
+                since = ev->stamp;
+                state = stPressed;
+            }
+            break;
+        case stHeld:
+        case stSecond:
+            if (ev->type == touchUp)
+                state = stIdle;
+            break;
+    }
+}
+
+/**
+    \brief Close the gestures that depend on elapsed time.
+*/
+static void on_time (uint32_t now)
+{
+    if (state == stTapped && elapsed(since, now) > GESTURE_DOUBLE_GAP) {
+        emit(gestureTap, since);
+        state = stIdle;
+    }
+    else if (state == stPressed && elapsed(since, now) >= GESTURE_HOLD) {
+        emit(gestureHold, now);
+        nextRepeat = now + GESTURE_REPEAT;
+        state = stHeld;
+    }
+    else if (state == stHeld && elapsed(nextRepeat, now) >= 0) {
+        emit(gestureRepeat, now);
+        nextRepeat += GESTURE_REPEAT;
+    }
+}
+
+/**
+    \brief Reset the recognizer.
+*/
+void gesture_init (void)
+{
+    head = tail = 0;
+    state = stIdle;
+}
+
+/**
+    \brief Get the next gesture.
+    \param g Destination.
+    \param now Current sysTicks.
+    \return TRUE when a gesture was copied to g.
+*/
+uint8_t gesture_get (gesture_t *g, uint32_t now)
+{
+    touch_event_t ev;
+
+    while (touch_event_get(&ev) == TRUE)
+        on_touch(&ev);
+    on_time(now);
+
+    if (tail == head)
+        return FALSE;
+    *g = queue[tail & (QUEUE_LEN - 1)];
+    tail++;
+    return TRUE;
+}
@@ -0,0 +1,54 @@
+/**
+    \file gesture.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Touch gesture recognizer: turns the touch event queue into
+    tap, double-tap, hold, auto-repeat and swipe events, timed from the
+    event stamps.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _GESTURE_H_
+#define _GESTURE_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Gesture
+    @{
+*/
+
+/* Timing, in sysTicks (10 ms) */
+#define GESTURE_TAP_MAX     30      /**< Longest press counted as a tap.         */
+#define GESTURE_DOUBLE_GAP  25      /**< Max release to press for a double-tap.  */
+#define GESTURE_HOLD        50      /**< Press time before gestureHold.          */
+#define GESTURE_REPEAT      15      /**< gestureRepeat period while held.        */
+#define GESTURE_SWIPE       96      /**< Position travel for a swipe (of 255).   */
+
+/** \brief Kind of gesture. */
+enum gestureType
+{
+    gestureTap = 1,                 /**< Short press and release.                */
+    gestureDoubleTap,               /**< Two taps in a row (on second press).    */
+    gestureHold,                    /**< Press kept for \ref GESTURE_HOLD.       */
+    gestureRepeat,                  /**< Every \ref GESTURE_REPEAT after a hold. */
+    gestureSwipeUp,                 /**< Slide towards position 255.             */
+    gestureSwipeDown                /**< Slide towards position 0.               */
+};
+
+/** \brief A recognized gesture. */
+typedef struct {
+    uint32_t stamp;                 /**< sysTicks when it was recognized.        */
+    uint8_t  type;                  /**< \ref gestureType.                       */
+    uint8_t  pos;                   /**< Slider position where it started.       */
+} gesture_t;
+
+void gesture_init (void);
+uint8_t gesture_get (gesture_t *g, uint32_t now);
+
+/** @} */ // Gesture
+
+#endif  // _GESTURE_H_
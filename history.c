@@ -0,0 +1,225 @@
+/**
+    \file history.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Multi-resolution sample history. Every sample costs a store
+    and an accumulate per channel; a rollup closes once per second (and
+    once per minute), which is the only place where a divide happens.
+    \note RAM usage is fixed: 172 bytes per channel, 1892 bytes for the
+    eleven channels of \ref sensorIdx.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "history.h"
+
+/** \brief Rollup as stored: 16-bit, relative to the channel bias. */
+typedef struct {
+    int16_t min;
+    int16_t max;
+    int16_t mean;
+} rollup_t;
+
+/** \brief Running accumulator of the period being built. */
+typedef struct {
+    int32_t sum;
+    int16_t min;
+    int16_t max;
+} accumulator_t;
+
+typedef struct {
+    int16_t       raw[HISTORY_RAW_LEN];
+    rollup_t      sec[HISTORY_SEC_LEN];
+    rollup_t      min[HISTORY_MIN_LEN];
+    accumulator_t accSec;
+    accumulator_t accMin;
+} channel_t;
+
+static channel_t history[HISTORY_CHANNELS];
+
+// Ring positions are shared: all the channels are sampled together
+static uint8_t rawHead, secHead, minHead;       // Next slot to write
+static uint8_t rawFill, secFill, minFill;       // Valid entries
+static uint8_t inSec;                           // Samples of current second
+static uint8_t inMin;                           // Seconds of current minute
+
+/**
+    \brief Unsigned 16-bit channels (ADC) are stored biased to fit an
+    int16_t; the bias is added back on every query.
+*/
+static inline int32_t bias (uint8_t channel)
+{
+    return (channel <= idxADC5) ? 32768 : 0;
+}
+
+static inline uint8_t next (uint8_t i, uint8_t size)
+{
+    if (++i >= size)                    // Avoid modulo or divide
+        i = 0;
+    return i;
+}
+
+static inline uint8_t fill (uint8_t n, uint8_t size)
+{
+    return (n < size) ? n + 1 : size;
+}
+
+static inline void acc_reset (accumulator_t *acc)
+{
+    acc->sum = 0;
+    acc->min = INT16_MAX;
+    acc->max = INT16_MIN;
+}
+
+static inline void acc_add (accumulator_t *acc, int16_t min, int16_t max, int16_t mean)
+{
+    acc->sum += mean;
+    if (min < acc->min) acc->min = min;
+    if (max > acc->max) acc->max = max;
+}
+
+static inline void acc_close (accumulator_t *acc, rollup_t *r, int32_t count)
+{
+    r->min  = acc->min;
+    r->max  = acc->max;
+    r->mean = acc->sum / count;
+    acc_reset(acc);
+}
+
+/**
+    \brief Clear the whole history.
+*/
+void history_init (void)
+{
+    uint8_t ch;
+    for (ch = 0; ch != HISTORY_CHANNELS; ch++) {
+        acc_reset(&history[ch].accSec);
+        acc_reset(&history[ch].accMin);
+    }
+    rawHead = secHead = minHead = 0;
+    rawFill = secFill = minFill = 0;
+    inSec = inMin = 0;
+}
+
+/**
+    \brief Append one snapshot to the history of every channel.
+    \param snap Snapshot to record; must be called at \ref HISTORY_RATE_HZ.
+*/
+void history_sample (const sensor_snapshot_t *snap)
+{
+    uint8_t ch;
+    uint8_t closeSec = (inSec == HISTORY_RATE_HZ - 1);
+    uint8_t closeMin = closeSec && (inMin == 60 - 1);
+
+    for (ch = 0; ch != HISTORY_CHANNELS; ch++) {
+        channel_t *c = &history[ch];
+        int16_t v = (int16_t)(sensor_value(snap, ch) - bias(ch));
+
+        c->raw[rawHead] = v;
+        acc_add(&c->accSec, v, v, v);
+        if (closeSec) {
+            rollup_t *r = &c->sec[secHead];
+            acc_close(&c->accSec, r, HISTORY_RATE_HZ);
+            acc_add(&c->accMin, r->min, r->max, r->mean);
+            if (closeMin) {
+                acc_close(&c->accMin, &c->min[minHead], 60);
+            }
+        }
+    }
+
+    rawHead = next(rawHead, HISTORY_RAW_LEN);
+    rawFill = fill(rawFill, HISTORY_RAW_LEN);
+    inSec = next(inSec, HISTORY_RATE_HZ);
+    if (closeSec) {
+        secHead = next(secHead, HISTORY_SEC_LEN);
+        secFill = fill(secFill, HISTORY_SEC_LEN);
+        inMin = next(inMin, 60);
+    }
+    if (closeMin) {
+        minHead = next(minHead, HISTORY_MIN_LEN);
+        minFill = fill(minFill, HISTORY_MIN_LEN);
+    }
+}
+
+/**
+    \brief Read the most recent full-rate samples of a channel.
+    \param channel Index, see \ref sensorIdx.
+    \param dst Destination, newest sample first.
+    \param n Maximum number of samples to copy.
+    \return Number of samples copied.
+*/
+uint8_t history_raw (uint8_t channel, int32_t *dst, uint8_t n)
+{
+    uint8_t i, k;
+    if (channel >= HISTORY_CHANNELS) return 0;
+    if (n > rawFill) n = rawFill;
+    i = rawHead;
+    for (k = 0; k != n; k++) {
+        i = (i == 0) ? HISTORY_RAW_LEN - 1 : i - 1;
+        dst[k] = history[channel].raw[i] + bias(channel);
+    }
+    return n;
+}
+
+/**
+    \brief Read the most recent rollups of a channel.
+    \param channel Index, see \ref sensorIdx.
+    \param level \ref HISTORY_LEVEL_SEC or \ref HISTORY_LEVEL_MIN.
+    \param dst Destination, newest period first.
+    \param n Maximum number of rollups to copy.
+    \return Number of rollups copied.
+*/
+uint8_t history_rollup (uint8_t channel, uint8_t level, history_stat_t *dst, uint8_t n)
+{
+    const rollup_t *ring;
+    uint8_t i, k, size;
+    int32_t b = bias(channel);
+
+    if (channel >= HISTORY_CHANNELS) return 0;
+    if (level == HISTORY_LEVEL_SEC) {
+        ring = history[channel].sec;
+        size = HISTORY_SEC_LEN;
+        i = secHead;
+        if (n > secFill) n = secFill;
+    }
+    else {
+        ring = history[channel].min;
+        size = HISTORY_MIN_LEN;
+        i = minHead;
+        if (n > minFill) n = minFill;
+    }
+    for (k = 0; k != n; k++) {
+        i = (i == 0) ? size - 1 : i - 1;
+        dst[k].min  = ring[i].min  + b;
+        dst[k].max  = ring[i].max  + b;
+        dst[k].mean = ring[i].mean + b;
+    }
+    return n;
+}
+
+/**
+    \brief Print the 1 s and 1 min trend of a channel on the console.
+    \param channel Index, see \ref sensorIdx.
+*/
+void history_print (uint8_t channel)
+{
+    history_stat_t stat[HISTORY_SEC_LEN];
+    uint8_t k, n;
+
+    n = history_rollup(channel, HISTORY_LEVEL_SEC, stat, HISTORY_SEC_LEN);
+    iprintf("\r\n   -s       min      mean       max\r\n");
+    for (k = 0; k != n; k++) {
+        iprintf("  %3d %9ld %9ld %9ld\r\n", k + 1,
+            (long) stat[k].min, (long) stat[k].mean, (long) stat[k].max);
+    }
+    n = history_rollup(channel, HISTORY_LEVEL_MIN, stat, HISTORY_MIN_LEN);
+    iprintf("   -m       min      mean       max\r\n");
+    for (k = 0; k != n; k++) {
+        iprintf("  %3d %9ld %9ld %9ld\r\n", k + 1,
+            (long) stat[k].min, (long) stat[k].mean, (long) stat[k].max);
+    }
+}
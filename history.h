@@ -0,0 +1,48 @@
+/**
+    \file history.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Multi-resolution sample history for every sensor channel: a
+    full-rate ring plus min/max/mean rollups at 1 s and 1 min.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _HISTORY_H_
+#define _HISTORY_H_
+
+#include <stdint.h>
+#include "types.h"
+#include "sensors.h"
+
+/**
+    \addtogroup History
+    @{
+*/
+
+#define HISTORY_CHANNELS    (SENSOR_LAST + 1)   /**< One per \ref sensorIdx.       */
+#define HISTORY_RATE_HZ     100     /**< Samples per second (SysTick rate).        */
+#define HISTORY_RAW_LEN     24      /**< Full-rate samples kept per channel.       */
+#define HISTORY_SEC_LEN     10      /**< 1 s rollups kept per channel.             */
+#define HISTORY_MIN_LEN     8       /**< 1 min rollups kept per channel.           */
+
+#define HISTORY_LEVEL_SEC   0       /**< Rollup level: one entry per second.       */
+#define HISTORY_LEVEL_MIN   1       /**< Rollup level: one entry per minute.       */
+
+/** \brief Summary of one rollup period. */
+typedef struct {
+    int32_t min;
+    int32_t max;
+    int32_t mean;
+} history_stat_t;
+
+void history_init (void);
+void history_sample (const sensor_snapshot_t *snap);
+uint8_t history_raw (uint8_t channel, int32_t *dst, uint8_t n);
+uint8_t history_rollup (uint8_t channel, uint8_t level, history_stat_t *dst, uint8_t n);
+void history_print (uint8_t channel);
+
+/** @} */ // History
+
+#endif  // _HISTORY_H_
@@ -23,20 +23,40 @@
 #include "driver_ADC.h"
 #include "driver_SYSTICK.h"
 #include "app_menu.h"
+#include "history.h"
+#include "tone.h"
+#include "sampler.h"
+#include "touch.h"
+#include "gesture.h"
+#include "boot.h"
+#include "clock.h"
+#include "console.h"
+#include "dma.h"
+#include "memory.h"
+#include "pool.h"
+#include "power.h"
+#include "profile.h"
+#include "stream.h"
+#include "timebase.h"
+#include "trace.h"
+#include "fmt.h"
 #include "pt.h"
 #include "pt-sem.h"
 #include "main.h"
 
 extern char *_sbrk(int len);
-uint32_t sysBuffer[11]; 
+volatile uint32_t sysTicks;
 
 /* Two flags that the two protothread functions use. */
-static uint8_t pthScanAdcFlag, pthScanAccelFlag, pthScanTouchFlag, pthCollectorFlag, pthStateAppMenuFlag;
+static uint8_t pthScanAdcFlag, pthScanAccelFlag, pthScanTouchFlag, pthCollectorFlag, pthStateAppMenuFlag, pthHistoryFlag;
 
 static struct pt ptScanAdc;
 static struct pt ptScanAccel;
 static struct pt ptScanTouch;
 static struct pt ptCollector;
+static struct pt ptHistory;
+static struct pt ptTrace;
+static struct pt ptTone;
 #ifdef DEBUG_MODE
 static struct pt ptMonitor;
 #else
@@ -50,6 +70,9 @@ static uint32_t pthScanAdc      (struct pt *pt);
 static uint32_t pthScanAccel    (struct pt *pt);
 static uint32_t pthScanTouch    (struct pt *pt);
 static uint32_t pthCollector    (struct pt *pt);
+static uint32_t pthHistory      (struct pt *pt);
+static uint32_t pthTrace        (struct pt *pt);
+static uint32_t pthTone         (struct pt *pt);
 static uint32_t pthStateAppMenu (struct pt *pt);
 static uint32_t pthMonitor      (struct pt *pt);
 
@@ -58,13 +81,28 @@ static uint32_t pthMonitor      (struct pt *pt);
  */
 void SysTick_Handler() __attribute__((interrupt("IRQ")));
 
+/* SysTick period stays 10 ms on every clock profile */
+static void systick_clock (const clock_info_t *clk)
+{
+    systick_reload_value(clk->core / HISTORY_RATE_HZ - 1);
+}
+
 // Main program
 int main(void)
 {
+    uint32_t primask;
+
+    boot_mark(bootMain);
+    mem_init();                             // Paint the free RAM, before any deep call
+    clock_init();
+    timebase_init();
+
     /*
      * Configuring SysTick
      */
-    systick_reload_value(systick_tenms()); // 100 Hz
+    boot_ticking();
+    systick_clock(clock_info());          // 100 Hz
+    clock_notify(systick_clock);
     systick_counter_value(0);
     systick_clock_source(CLOCK_SOURCE_PROCESSOR);
     systick_enable(ON); 
@@ -83,12 +121,22 @@ int main(void)
     /*
      * Initialization of left modules
      */
+    pool_init();                            // First user of the heap
+    dma_init();                             // Before the drivers that claim channels
+#ifndef FAST_BOOT
+    dma_copy_calibrate();                   // A couple of ms
+#endif
     uart_init(115200);
     accel_init();
-    touch_init((1 << 9) | (1 << 10));       // Channels 9 and 10
-    // usb_init();
+    touch_init((1 << TOUCH_CH_LOW) | (1 << TOUCH_CH_HIGH));
+    usb_init();
+    console_init();                         // stdout on USB CDC when open
+    stream_init();
+    power_init();
+    power_wake_enable(POWER_WAKE_SYSTICK | POWER_WAKE_USB | POWER_WAKE_UART_RX | POWER_WAKE_TSI);
     setvbuf(stdin, NULL, _IONBF, 0);        // No buffering
 
+#ifndef FAST_BOOT
     /*
      * Run tests
      */
@@ -104,6 +152,7 @@ int main(void)
         pattern >>= 1;
         delay(25);
     }
+#endif
 
     /*
      * Initialization of flags
@@ -113,6 +162,7 @@ int main(void)
     pthScanTouchFlag    = FALSE;
     pthCollectorFlag    = FALSE;
     pthStateAppMenuFlag = FALSE;
+    pthHistoryFlag      = FALSE;
     
     /* 
      * Initialize the protothread state variables with PT_INIT()
@@ -120,6 +170,9 @@ int main(void)
     PT_INIT(&ptScanAdc);
     PT_INIT(&ptScanAccel);
     PT_INIT(&ptScanTouch);
+    PT_INIT(&ptHistory);
+    PT_INIT(&ptTrace);
+    PT_INIT(&ptTone);
     #ifdef DEBUG_MODE
     PT_INIT(&ptCollector);
     #else
@@ -130,20 +183,38 @@ int main(void)
      * Initialize state-machine of serial menu
      */
     InitAppMenu ();
+    gesture_init ();
+    history_init ();
+    tone_init (SAMPLER_RATE_HZ);
+    sampler_init ();                    // Owns the ADC from here on
     
+    boot_mark(bootDrivers);
+
     /* 
      * Scheduler for protothreads (cooperative context) 
      */
+    boot_mark(bootScheduler);
     for (;;) {
+        power_dispatch  ();
         pthScanAdc      (&ptScanAdc);
         pthScanAccel    (&ptScanAccel);
         pthScanTouch    (&ptScanTouch);
         pthCollector    (&ptCollector);
+        pthHistory      (&ptHistory);
+        pthTrace        (&ptTrace);
+        pthTone         (&ptTone);
         #ifdef DEBUG_MODE
         pthMonitor      (&ptMonitor);
         #else
         pthStateAppMenu (&ptStateAppMenu);
         #endif
+
+        /* Scans of this period done: sleep until the next interrupt */
+        primask = __irq_save();
+        if (pthScanAdcFlag && pthScanAccelFlag && pthScanTouchFlag &&
+            pthHistoryFlag && !pthCollectorFlag)
+            power_sleep();
+        __irq_restore(primask);
     }
 }
 
@@ -153,35 +224,39 @@ int main(void)
  */
 static uint32_t pthScanAdc (struct pt *pt)
 {
+    /* Conversions are kept here until the whole scan is published */
+    static uint16_t adcScan[SENSOR_ADC_CHANNELS];
     /* A protothread function must begin with PT_BEGIN() which takes a
      pointer to a struct pt. */
     PT_BEGIN(pt);
     /* Wait until the other protothread has set its flag. */
     PT_WAIT_UNTIL(pt, pthScanAdcFlag == FALSE);
-    adc_channel (ADC_AD8); // Software event - Channel A0 
+    sampler_convert (ADC_AD8); // Between A0 slots - Channel A0 
     
-    PT_WAIT_UNTIL(pt, adc_data_is_ready() == TRUE);
-    sysBuffer[idxADC0] = adc_data_get();
-    adc_channel (ADC_AD9); // Software event - Channel A1
+    PT_WAIT_UNTIL(pt, sampler_ready() == TRUE);
+    adcScan[0] = sampler_result();
+    sampler_convert (ADC_AD9); // Channel A1
     
-    PT_WAIT_UNTIL(pt, adc_data_is_ready() == TRUE);
-    sysBuffer[idxADC1] = adc_data_get();
-    adc_channel (ADC_AD12); // Software event - Channel A2         
+    PT_WAIT_UNTIL(pt, sampler_ready() == TRUE);
+    adcScan[1] = sampler_result();
+    sampler_convert (ADC_AD12); // Channel A2         
     
-    PT_WAIT_UNTIL(pt, adc_data_is_ready() == TRUE);
-    sysBuffer[idxADC2] = adc_data_get();
-    adc_channel (ADC_AD13); // Software event - Channel A3 
+    PT_WAIT_UNTIL(pt, sampler_ready() == TRUE);
+    adcScan[2] = sampler_result();
+    sampler_convert (ADC_AD13); // Channel A3 
     
-    PT_WAIT_UNTIL(pt, adc_data_is_ready() == TRUE);
-    sysBuffer[idxADC3] = adc_data_get();
-    adc_channel (ADC_AD11); // Software event - Channel A4
+    PT_WAIT_UNTIL(pt, sampler_ready() == TRUE);
+    adcScan[3] = sampler_result();
+    sampler_convert (ADC_AD11); // Channel A4
     
-    PT_WAIT_UNTIL(pt, adc_data_is_ready() == TRUE);
-    sysBuffer[idxADC4] = adc_data_get();
-    adc_channel (ADC_AD15); // Software event - Channel A5 
+    PT_WAIT_UNTIL(pt, sampler_ready() == TRUE);
+    adcScan[4] = sampler_result();
+    sampler_convert (ADC_AD15); // Channel A5 
     
-    PT_WAIT_UNTIL(pt, adc_data_is_ready() == TRUE);
-    sysBuffer[idxADC5] = adc_data_get();
+    PT_WAIT_UNTIL(pt, sampler_ready() == TRUE);
+    adcScan[5] = sampler_result();
+    sensor_publish_adc (adcScan);
+    boot_mark (bootFirstSample);
     
     pthScanAdcFlag = TRUE;
     PT_END(pt);
@@ -192,14 +267,16 @@ static uint32_t pthScanAdc (struct pt *pt)
  */
 static uint32_t pthScanAccel (struct pt *pt)
 {
+    int16_t x, y, z;
     /* A protothread function must begin with PT_BEGIN() which takes a
      pointer to a struct pt. */
     PT_BEGIN(pt);
     /* Wait until the other protothread has set its flag. */
     PT_WAIT_UNTIL(pt, pthScanAccelFlag == FALSE);
-    sysBuffer[idxAccelX] = accel_x();
-    sysBuffer[idxAccelY] = accel_y();
-    sysBuffer[idxAccelZ] = accel_z();
+    x = accel_x();
+    y = accel_y();
+    z = accel_z();
+    sensor_publish_accel (x, y, z);
     pthScanAccelFlag = TRUE;
     PT_END(pt);
 }
@@ -214,48 +291,118 @@ static uint32_t pthScanTouch (struct pt *pt)
     PT_BEGIN(pt);
     /* Wait until the other protothread has set its flag. */
     PT_WAIT_UNTIL(pt, pthScanTouchFlag == FALSE);
-    sysBuffer[idxTouchDataX] = touch_data(9);
-    sysBuffer[idxTouchDataY] = touch_data(10);
+    sensor_publish_touch (touch_data(TOUCH_CH_LOW), touch_data(TOUCH_CH_HIGH));
     pthScanTouchFlag = TRUE;
     PT_END(pt);
 }
 
 /*
- * This protothread make possible use capacitive touch like as two 
- * buttons over the board 
+ * This protothread records one snapshot per SysTick period into the
+ * sample history
  */
-static uint32_t pthCollector (struct pt *pt) 
+static uint32_t pthHistory (struct pt *pt)
 {
+    static uint8_t powerCount;
+    static power_stat_t power;
+    sensor_snapshot_t snap;
     PT_BEGIN(pt);
     PT_WAIT_UNTIL(pt, 
+        (pthHistoryFlag == FALSE) &&
         (pthScanTouchFlag == TRUE) &&
         (pthScanAccelFlag == TRUE) &&
         (pthScanAdcFlag == TRUE)
     );
-    if ((sysBuffer[idxTouchDataY] > 500) && (sysBuffer[idxTouchDataX] < 500) && (sysBuffer[idxTouchDataX] > 30))
+    sensor_read (&snap);
+    history_sample (&snap);
+    stream_snapshot (&snap);
+    if (++powerCount == HISTORY_RATE_HZ) {  /* Power counters, once a second */
+        powerCount = 0;
+        power_stats (&power);
+        stream_record (STREAM_KIND_POWER, &power, sizeof(power));
+    }
+    pthHistoryFlag = TRUE;
+    PT_END(pt);
+}
+
+/*
+ * This protothread runs the tone detector over every A0 block of the
+ * sampler and reports the bins that change state
+ */
+static uint32_t pthTone (struct pt *pt)
+{
+    static const uint16_t *block;
+    static tone_report_t report;
+    uint8_t k;
+    PT_BEGIN(pt);
+    PT_WAIT_UNTIL(pt, (block = sampler_block ()) != NULL);
+    tone_feed_block (block, SAMPLER_BLOCK);
+    sampler_release ();
+    report.changed = tone_events ();
+    if (report.changed)
     {
-        if (EventAppMenu != eUp)
-        {
-            EventAppMenu = eUp;
-            pthCollectorFlag = TRUE;
-        }
+        report.detected = tone_detected ();
+        for (k = 0; k != TONE_BINS; k++)
+            report.power[k] = tone_power (k);
+        TRACE("tone: detected 0x%02lx, changed 0x%02lx", report.detected, report.changed);
+        stream_record (STREAM_KIND_TONE, &report, sizeof(report));
     }
-    else if ((sysBuffer[idxTouchDataY] > 30) && (sysBuffer[idxTouchDataY] < 500) && (sysBuffer[idxTouchDataX] > 500))
+    PT_END(pt);
+}
+
+/*
+ * This protothread formats the trace records left by interrupt
+ * handlers, one per pass so it never holds the scheduler
+ */
+static uint32_t pthTrace (struct pt *pt)
+{
+    static trace_record_t rec;
+    uint16_t lost;
+    PT_BEGIN(pt);
+    PT_WAIT_UNTIL(pt, trace_get (&rec) == TRUE);
+    lost = trace_lost ();
+    if (lost)
     {
-        if (EventAppMenu != eSelect)
-        {
-            EventAppMenu = eSelect;
-            pthCollectorFlag = TRUE;
-        }
+        iprintf("trace: %u records lost\r\n", lost);
     }
-    else
+    trace_print (&rec);
+    PT_END(pt);
+}
+
+/*
+ * This protothread translates touch gestures into menu events:
+ *   tap            eUp on the channel 10 half, eSelect on the channel 9 half
+ *   hold, repeat   eUp / eDown, auto-scroll while the finger stays
+ *   swipe          eUp / eDown by direction
+ *   double-tap     eBack
+ */
+static uint32_t pthCollector (struct pt *pt) 
+{
+    static gesture_t g;
+    PT_BEGIN(pt);
+    PT_WAIT_UNTIL(pt, 
+        (pthCollectorFlag == FALSE) &&
+        (gesture_get (&g, sysTicks) == TRUE)
+    );
+    switch (g.type)
     {
-        EventAppMenu = eNoEvent; /* Event reset */
-        PT_EXIT(pt);
+        case gestureTap:
+            EventAppMenu = (g.pos >= TOUCH_POS_MID) ? eUp : eSelect;
+            break;
+        case gestureHold:
+        case gestureRepeat:
+            EventAppMenu = (g.pos >= TOUCH_POS_MID) ? eUp : eDown;
+            break;
+        case gestureSwipeUp:
+            EventAppMenu = eUp;
+            break;
+        case gestureSwipeDown:
+            EventAppMenu = eDown;
+            break;
+        case gestureDoubleTap:
+            EventAppMenu = eBack;
+            break;
     }
-    pthScanAdcFlag    = FALSE;
-    pthScanAccelFlag  = FALSE;
-    pthScanTouchFlag  = FALSE;
+    pthCollectorFlag = TRUE;
     PT_END(pt);
 } 
 
@@ -265,7 +412,13 @@ static uint32_t pthCollector (struct pt *pt)
 static uint32_t pthStateAppMenu (struct pt *pt)
 {
     PT_BEGIN(pt);
-    PT_WAIT_UNTIL(pt, pthCollectorFlag == TRUE);
+    PT_WAIT_UNTIL(pt, (pthCollectorFlag == TRUE) || aRefreshDue());
+    if (pthCollectorFlag == FALSE)
+    {
+        /* No event: redraw the live task, only changed rows are sent */
+        aTask (AppStringSubmenu[vSubmenu], vSubmenu, vItem);
+        PT_EXIT(pt);
+    }
     pthCollectorFlag = FALSE; /* Reset */
     if (StateAppMenu == MENU)
     {
@@ -287,6 +440,18 @@ static uint32_t pthStateAppMenu (struct pt *pt)
             }
             aPrint (AppStringMenu, vSubmenu);
         }
+        else if (EventAppMenu == eDown)
+        {
+            if (vSubmenu == 0)
+            {
+                vSubmenu = lastItem(AppStringMenu);
+            }
+            else
+            {
+                vSubmenu --;
+            }
+            aPrint (AppStringMenu, vSubmenu);
+        }
     }
     else if (StateAppMenu == SUBMENU)
     {
@@ -316,16 +481,37 @@ static uint32_t pthStateAppMenu (struct pt *pt)
             }
             aPrint (AppStringSubmenu[vSubmenu], vItem);
         }
+        else if (EventAppMenu == eDown) 
+        {
+            if (vItem == 0) 
+            {
+                vItem = lastItem(AppStringSubmenu[vSubmenu]);
+            }
+            else
+            {
+                vItem --;
+            }
+            aPrint (AppStringSubmenu[vSubmenu], vItem);
+        }
+        else if (EventAppMenu == eBack) 
+        {
+            aPrint (AppStringMenu, vSubmenu);
+            StateAppMenu = MENU;
+        }
     }
     else if (StateAppMenu == TASK) 
     {
-        if (EventAppMenu == eUp) 
+        if ((EventAppMenu == eUp) || (EventAppMenu == eDown)) 
         {
             StateAppMenu = SUBMENU;
         }
         else if (EventAppMenu == eSelect) {
             aTask (AppStringSubmenu[vSubmenu], vSubmenu, vItem);
         }
+        else if (EventAppMenu == eBack) {
+            aPrint (AppStringSubmenu[vSubmenu], vItem);
+            StateAppMenu = SUBMENU;
+        }
     }
     PT_END(pt);
 }
@@ -333,19 +519,30 @@ static uint32_t pthStateAppMenu (struct pt *pt)
 /*
  * The interrupt handler for SysTick module on ARM core 
  */
-void SysTick_Handler() {
+RAMFUNC void SysTick_Handler() {
     static uint8_t change;
+    PROF_ISR(profSysTick);
+    sysTicks++;
     change = ~change;
     if (change) RGB_LED (0x00, 0x00, 0xFF);
     else RGB_LED (0x00, 0xFF, 0x00);
     pthScanAdcFlag    = FALSE;
     pthScanAccelFlag  = FALSE;
     pthScanTouchFlag  = FALSE;
+    pthHistoryFlag    = FALSE;
+    touch_tick ();
 }
 
 #ifdef DEBUG_MODE
 static uint32_t pthMonitor (struct pt *pt)
 {
+    static char line[96];
+    static const char *const analog[SENSOR_ADC_CHANNELS] = {
+        " A0 = ", " A1 = ", " A2 = ", " A3 = ", " A4 = ", " A5 = "
+    };
+    sensor_snapshot_t snap;
+    fmt_t f;
+    uint8_t i;
     /* A protothread function must begin with PT_BEGIN() which takes a
      pointer to a struct pt. */
     PT_BEGIN(pt);
@@ -354,12 +551,30 @@ static uint32_t pthMonitor (struct pt *pt)
     PT_WAIT_UNTIL(pt, pthScanAdcFlag    == TRUE );
     PT_WAIT_UNTIL(pt, pthScanAccelFlag  == TRUE );
     PT_WAIT_UNTIL(pt, pthScanTouchFlag  == TRUE );
-    if ((int32_t) (sysBuffer[idxTouchDataY]) > 10) {
-        iprintf("\033[2J\033[1;1H");
-        iprintf("> Request: \r\n");
-        iprintf("  Analog: A0 = %5d A1 = %5d A2 = %5d A3 = %5d A4 = %5d A5 = %5d\r\n", sysBuffer[idxADC0], sysBuffer[idxADC1], sysBuffer[idxADC2], sysBuffer[idxADC3], sysBuffer[idxADC4], sysBuffer[idxADC5]);
-        iprintf("  Inputs:  X = %5d  Y = %5d  Z = %5d\r\n", sysBuffer[idxAccelX], sysBuffer[idxAccelY], sysBuffer[idxAccelZ]);
-        iprintf("  Touch:       %5d      %5d\r\n", sysBuffer[idxTouchDataX], sysBuffer[idxTouchDataY]);
+    sensor_read (&snap);
+    if (snap.touch[1] > 10) {
+        fmt_init (&f, line, sizeof(line));
+        fmt_str (&f, "\033[2J\033[1;1H> Request: \r\n  Analog:");
+        for (i = 0; i != SENSOR_ADC_CHANNELS; i++) {
+            fmt_str (&f, analog[i]);
+            fmt_u32 (&f, snap.adc[i], 5, ' ');
+        }
+        fmt_str (&f, "\r\n  Inputs:  X = ");
+        fmt_i32 (&f, snap.accel[0], 5, ' ');
+        fmt_str (&f, "  Y = ");
+        fmt_i32 (&f, snap.accel[1], 5, ' ');
+        fmt_str (&f, "  Z = ");
+        fmt_i32 (&f, snap.accel[2], 5, ' ');
+        fmt_str (&f, "\r\n  Touch:       ");
+        fmt_i32 (&f, snap.touch[0], 5, ' ');
+        fmt_str (&f, "      ");
+        fmt_i32 (&f, snap.touch[1], 5, ' ');
+        fmt_str (&f, "\r\n  Tones: ");
+        fmt_hex (&f, tone_detected(), 2);
+        fmt_str (&f, " (enabled ");
+        fmt_hex (&f, tone_enabled(), 2);
+        fmt_str (&f, ")\r\n");
+        fmt_flush (&f);
         blink (FAULT_SLOW_BLINK, 10);
         RGB_LED(0, 0b1100110011001100, 0); 
     }
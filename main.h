@@ -12,22 +12,5 @@
 #ifndef _MAIN_H_
 #define _MAIN_H_
 
-/** \brief Main buffer of the system. */
-enum sysBufferIdx
-{
-    idxADC0 = 0,
-    idxADC1,
-    idxADC2,
-    idxADC3,
-    idxADC4,
-    idxADC5,
-    idxAccelX,
-    idxAccelY,
-    idxAccelZ,
-    idxTouchDataX,
-    idxTouchDataY
-};
-
-#define SYS_BUFFER_LAST 10
-extern uint32_t sysBuffer[11]; 
+#include "sensors.h"
 #endif
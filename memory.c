@@ -0,0 +1,111 @@
+/**
+    \file memory.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Heap and stack accounting. The heap grows up from the end of
+    .bss and the stack down from the top of RAM; _sbrk refuses to cross
+    __StackLimit or to come within \ref MEM_GUARD bytes of the stack
+    pointer. The RAM between them is painted at boot, so the deepest
+    stack use is the lowest word that lost the pattern.
+    \note The stack scan reads every free word: call \ref mem_stats from
+    the main loop, not from an interrupt.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include "freedom.h"
+#include "common.h"
+#include "memory.h"
+
+static char *heap_end = (char *) __heap_start;
+static char *heapPeak = (char *) __heap_start;
+static uint32_t *paintStart;            // Lowest painted word
+static uint32_t minGap = UINT32_MAX;
+static uint16_t refused;
+
+static inline char *stack_pointer (void)
+{
+    char *sp;
+    __asm volatile ("mov %0, sp" : "=r" (sp));
+    return sp;
+}
+
+static inline void gap (char *heap, char *stack)
+{
+    uint32_t g = (stack > heap) ? (uint32_t)(stack - heap) : 0;
+    if (g < minGap)
+        minGap = g;
+}
+
+// ------------------------------------------------------------------------------------
+// _sbrk(len) -- Allocate space on the heap
+//
+char *_sbrk (int incr)
+{
+    char *prev = heap_end;
+    char *next = heap_end + incr;
+    char *sp = stack_pointer();
+
+    if (next > (char *) __StackLimit || next > sp - MEM_GUARD) {
+        refused++;
+        errno = ENOMEM;
+        return (char *) -1;
+    }
+    heap_end = next;
+    if (next > heapPeak)
+        heapPeak = next;
+    gap(next, sp);
+    return prev;
+}
+
+/**
+    \brief Paint the free RAM between the heap and the stack. Call once,
+    first thing in main, so the stack peak covers the initialization.
+*/
+void mem_init (void)
+{
+    uint32_t *p = (uint32_t *)(((uint32_t) heap_end + 3) & ~3);
+    uint32_t *end = (uint32_t *)((uint32_t)(stack_pointer() - 64) & ~3);
+
+    paintStart = p;
+    while (p < end)                     // Leave the live frames alone
+        *p++ = MEM_PAINT;
+}
+
+/**
+    \brief Measure the RAM usage.
+*/
+void mem_stats (mem_stat_t *stat)
+{
+    uint32_t *p = paintStart;
+    char *heap = heapPeak;
+
+    if ((char *) p < heap)              // The heap took part of the paint
+        p = (uint32_t *)(((uint32_t) heap + 3) & ~3);
+    while (p < __StackTop && *p == MEM_PAINT)
+        p++;
+    gap(heap, (char *) p);
+
+    stat->heapUsed = heap_end - (char *) __heap_start;
+    stat->heapPeak = heap - (char *) __heap_start;
+    stat->stackPeak = (char *) __StackTop - (char *) p;
+    stat->minGap = minGap;
+    stat->refused = refused;
+}
+
+/**
+    \brief Print the RAM usage on the console.
+*/
+void mem_print (void)
+{
+    mem_stat_t s;
+
+    mem_stats(&s);
+    iprintf("     heap %lu (peak %lu)\r\n", (unsigned long) s.heapUsed, (unsigned long) s.heapPeak);
+    iprintf("    stack %lu (peak)\r\n", (unsigned long) s.stackPeak);
+    iprintf("  min gap %lu\r\n", (unsigned long) s.minGap);
+    iprintf("  refused %u\r\n", s.refused);
+}
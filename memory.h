@@ -0,0 +1,41 @@
+/**
+    \file memory.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Heap and stack accounting: a guarded _sbrk and high-water
+    marks of both ends of the free RAM, found by painting it at boot.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _MEMORY_H_
+#define _MEMORY_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Memory
+    @{
+*/
+
+#define MEM_GUARD       256         /**< Bytes the heap keeps below the live SP. */
+#define MEM_PAINT       0xA5A5A5A5  /**< Pattern of never used RAM.              */
+
+/** \brief RAM usage since boot, in bytes. */
+typedef struct {
+    uint32_t heapUsed;          /**< Heap handed out now.                       */
+    uint32_t heapPeak;          /**< Most heap ever handed out.                 */
+    uint32_t stackPeak;         /**< Deepest stack seen in the paint.           */
+    uint32_t minGap;            /**< Smallest distance seen between both.       */
+    uint16_t refused;           /**< _sbrk calls refused.                       */
+} mem_stat_t;
+
+void mem_init (void);
+void mem_stats (mem_stat_t *stat);
+void mem_print (void);
+
+/** @} */ // Memory
+
+#endif  // _MEMORY_H_
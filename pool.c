@@ -0,0 +1,160 @@
+/**
+    \file pool.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Fixed-size block pools. Every class is one contiguous area
+    of the heap with a free list threaded through its free blocks, so
+    both allocate and free are a pointer swap under masked interrupts
+    (under 20 cycles); free finds the class by address.
+    \note A request is served by the smallest class that fits, or by the
+    next larger one when that class is empty. A failure is counted on
+    the smallest class that fits.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "pool.h"
+
+extern char *_sbrk(int len);
+
+typedef struct block {
+    struct block *next;
+} block_t;
+
+typedef struct {
+    uint8_t  *start;            // First block; NULL when not carved
+    uint8_t  *end;              // Past the last block
+    block_t  *free;
+    pool_stat_t stat;
+} pool_class_t;
+
+static pool_class_t pools[POOL_CLASSES] = {
+    { .stat = { .size = POOL_SMALL_SIZE,  .len = POOL_SMALL_LEN  } },
+    { .stat = { .size = POOL_PACKET_SIZE, .len = POOL_PACKET_LEN } },
+    { .stat = { .size = POOL_BLOCK_SIZE,  .len = POOL_BLOCK_LEN  } },
+};
+
+/**
+    \brief Carve every class from the heap. Call once, before anything
+    else takes heap memory.
+*/
+void pool_init (void)
+{
+    uint8_t cls, i;
+    char *p;
+
+    p = _sbrk(0);                                   // Word align the areas
+    _sbrk((4 - ((uint32_t) p & 3)) & 3);
+    for (cls = 0; cls != POOL_CLASSES; cls++) {
+        pool_class_t *c = &pools[cls];
+        uint16_t size = (c->stat.size + 3) & ~3;
+
+        c->stat.size = size;
+        p = _sbrk(size * c->stat.len);
+        if (p == (char *) -1)
+            continue;                               // Class left empty
+        c->start = (uint8_t *) p;
+        c->end = c->start + size * c->stat.len;
+        c->free = NULL;
+        for (i = c->stat.len; i != 0; i--) {        // Lowest address first
+            block_t *b = (block_t *)(c->start + (i - 1) * size);
+            b->next = c->free;
+            c->free = b;
+        }
+    }
+}
+
+/**
+    \brief Take a block.
+    \param size Bytes needed.
+    \return The block (word aligned), or NULL.
+*/
+void *pool_alloc (uint16_t size)
+{
+    uint8_t cls, first = POOL_CLASSES;
+    uint32_t primask = __irq_save();
+
+    for (cls = 0; cls != POOL_CLASSES; cls++) {
+        pool_class_t *c = &pools[cls];
+        block_t *b;
+
+        if (size > c->stat.size)
+            continue;
+        if (first == POOL_CLASSES)
+            first = cls;
+        b = c->free;
+        if (b != NULL) {
+            c->free = b->next;
+            if (++c->stat.used > c->stat.highWater)
+                c->stat.highWater = c->stat.used;
+            __irq_restore(primask);
+            return b;
+        }
+    }
+    if (first != POOL_CLASSES)
+        pools[first].stat.fails++;
+    __irq_restore(primask);
+    return NULL;
+}
+
+/**
+    \brief Give a block back; NULL is ignored.
+*/
+RAMFUNC void pool_free (void *p)
+{
+    uint8_t cls;
+    uint32_t primask;
+
+    if (p == NULL)
+        return;
+    primask = __irq_save();
+    for (cls = 0; cls != POOL_CLASSES; cls++) {
+        pool_class_t *c = &pools[cls];
+        if ((uint8_t *) p >= c->start && (uint8_t *) p < c->end) {
+            block_t *b = p;
+            b->next = c->free;
+            c->free = b;
+            c->stat.used--;
+            break;
+        }
+    }
+    __irq_restore(primask);
+    if (cls == POOL_CLASSES)
+        fault(0b10101100);                          // Not a pool block
+}
+
+/**
+    \brief Read the usage of a class.
+    \param cls Class, 0 is the smallest.
+    \return FALSE when the class does not exist.
+*/
+uint8_t pool_stats (uint8_t cls, pool_stat_t *stat)
+{
+    uint32_t primask;
+
+    if (cls >= POOL_CLASSES)
+        return FALSE;
+    primask = __irq_save();
+    *stat = pools[cls].stat;
+    __irq_restore(primask);
+    return TRUE;
+}
+
+/**
+    \brief Print the usage of every class on the console.
+*/
+void pool_print (void)
+{
+    pool_stat_t s;
+    uint8_t cls;
+
+    iprintf("  size len used peak fails\r\n");
+    for (cls = 0; pool_stats(cls, &s); cls++) {
+        iprintf("  %4u %3u %4u %4u %5u\r\n", s.size, s.len, s.used,
+            s.highWater, s.fails);
+    }
+}
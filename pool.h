@@ -0,0 +1,50 @@
+/**
+    \file pool.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Fixed-size block pools carved from the heap once at boot:
+    constant time allocate and free, no fragmentation, usable from
+    interrupts.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _POOL_H_
+#define _POOL_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Pool
+    @{
+*/
+
+#define POOL_CLASSES    3       /**< Size classes, smallest first.             */
+
+#define POOL_SMALL_SIZE 16      /**< CDC notification packets, small records.  */
+#define POOL_SMALL_LEN  8
+#define POOL_PACKET_SIZE 64     /**< One full-speed USB packet (CDC bulk).     */
+#define POOL_PACKET_LEN 4
+#define POOL_BLOCK_SIZE 512     /**< Stream blocks.                            */
+#define POOL_BLOCK_LEN  3
+
+/** \brief Usage of one size class. */
+typedef struct {
+    uint16_t size;              /**< Bytes per block.                          */
+    uint8_t  len;               /**< Blocks in the class.                      */
+    uint8_t  used;              /**< Blocks allocated now.                     */
+    uint8_t  highWater;         /**< Most blocks ever allocated at once.       */
+    uint16_t fails;             /**< Requests refused for lack of a block.     */
+} pool_stat_t;
+
+void pool_init (void);
+void *pool_alloc (uint16_t size);
+void pool_free (void *p);
+uint8_t pool_stats (uint8_t cls, pool_stat_t *stat);
+void pool_print (void);
+
+/** @} */ // Pool
+
+#endif  // _POOL_H_
@@ -0,0 +1,317 @@
+/**
+    \file power.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Power management with the SMC and the LLWU. The sleep mode is
+    the deepest one allowed by every enabled wake source, and no deeper
+    than WAIT while the UART is still sending. Peripherals keep their
+    registers in all these modes; only the clocks need care on wake:
+    the PLL relocks before \ref power_sleep returns.
+    \note A WAIT sleep ends at the next interrupt of any kind. The stop
+    modes only end on the enabled sources, so SysTick time is lost
+    while stopped: a timed stop uses the LPTMR alarm instead, see
+    \ref power_wake_after and \ref power_standby.
+    \note Accounting: run and WAIT time come from the microsecond
+    timebase, added up on every pass, refused sleeps included. The PIT
+    stops in VLPS and LLS, so the stop modes are timed with the 1 kHz
+    LPTMR. The wake latency starts at the SysTick reload when SysTick
+    woke the core, else when WFI returns (before the PLL relock, after
+    a stop), and ends at \ref power_dispatch.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "clock.h"
+#include "timebase.h"
+#include "power.h"
+
+#define STOPM_NORMAL    0           // SMC_PMCTRL[STOPM] values
+#define STOPM_VLPS      2
+#define STOPM_LLS       3
+
+// The touch idle scans are started by touch_tick() on SysTick, which
+// stops in VLPS and LLS: no scan would run there to see a finger
+#define WAKE_WAIT       (POWER_WAKE_SYSTICK | POWER_WAKE_USB | POWER_WAKE_TSI)
+#define WAKE_VLPS       (POWER_WAKE_UART_RX | POWER_WAKE_PORT)
+
+static uint32_t wake;               // Enabled sources
+static power_stat_t stats;
+static uint64_t lastWake;           // Microseconds when run time was last counted
+static uint64_t wakeStamp;          // Microseconds of the wake event
+static uint8_t dispatchDue;         // Latency not measured yet
+
+// Interrupt of every wake source, in \ref powerWake bit order
+static const int8_t wakeIrq[POWER_SOURCES - 1] = {
+    -1, INT_USB0, INT_UART0, INT_PORTA, INT_LPTimer, INT_TSI0, INT_LLW
+};
+
+static const char *const names[POWER_MODES] = {
+    "run", "wait", "vlps", "lls"
+};
+
+static inline uint32_t to_us (uint32_t cycles)
+{
+    return cycles / (clock_info()->core / 1000000);
+}
+
+// Count the sources that ended a sleep; they are still pending
+static void count_wakes (void)
+{
+    uint32_t ispr = NVIC_ISPR;
+    uint8_t i, any = FALSE;
+
+    if (SCB_ICSR & SCB_ICSR_PENDSTSET_MASK) {
+        stats.wakes[0]++;
+        any = TRUE;
+    }
+    for (i = 1; i != POWER_SOURCES - 1; i++) {
+        if (ispr & (1 << (wakeIrq[i] - 16))) {
+            stats.wakes[i]++;
+            any = TRUE;
+        }
+    }
+    if (!any)
+        stats.wakes[POWER_SOURCES - 1]++;
+}
+
+/**
+    \brief Clear the LLWU flags; the module flag (LPTMR) is cleared by
+    its own handler.
+*/
+void LLW_IRQHandler() __attribute__((interrupt("IRQ")));
+void LLW_IRQHandler(void)
+{
+    LLWU_F1 = 0xFF;
+    LLWU_F2 = 0xFF;
+}
+
+/**
+    \brief No wake source enabled: the main loop does not sleep.
+*/
+void power_init (void)
+{
+    wake = 0;
+    LLWU_ME = 0;
+    LLWU_PE1 = LLWU_PE2 = LLWU_PE3 = LLWU_PE4 = 0;
+    enable_irq(INT_LLW);
+}
+
+/**
+    \brief Add wake sources; see \ref powerWake.
+*/
+void power_wake_enable (uint32_t sources)
+{
+    wake |= sources;
+    if (sources & POWER_WAKE_LPTMR)
+        LLWU_ME |= LLWU_ME_WUME0_MASK;
+}
+
+/**
+    \brief Remove wake sources; see \ref powerWake.
+*/
+void power_wake_disable (uint32_t sources)
+{
+    wake &= ~sources;
+    if (sources & POWER_WAKE_LPTMR)
+        LLWU_ME &= ~LLWU_ME_WUME0_MASK;
+}
+
+/**
+    \brief Route an LLWU pin (P5 = PTB0, P6 = PTC1 ... see the reference
+    manual) as wake source; \ref POWER_WAKE_PIN must be enabled too.
+    \param pin LLWU pin, 0 to 15.
+    \param edge \ref POWER_EDGE_RISING, \ref POWER_EDGE_FALLING,
+    \ref POWER_EDGE_ANY, or 0 to remove it.
+*/
+void power_wake_pin (uint8_t pin, uint8_t edge)
+{
+    volatile uint8_t *pe[4] = { &LLWU_PE1, &LLWU_PE2, &LLWU_PE3, &LLWU_PE4 };
+    uint8_t shift = (pin & 3) * 2;
+
+    if (pin > 15)
+        return;
+    *pe[pin >> 2] = (*pe[pin >> 2] & ~(3 << shift)) | ((edge & 3) << shift);
+}
+
+/**
+    \brief Wake up in \p ms milliseconds (1 to 65535), from any mode.
+    One shot, replacing the last one; 0 cancels it. Takes effect in the
+    stop modes only with \ref POWER_WAKE_LPTMR enabled. Main loop only.
+*/
+void power_wake_after (uint16_t ms)
+{
+    lptmr_alarm(ms);
+}
+
+/**
+    \brief Deepest mode every enabled source survives.
+*/
+uint8_t power_mode_allowed (void)
+{
+    if (wake == 0)
+        return powerRun;                // Nothing would wake us up
+    if ((wake & WAKE_WAIT) || !uart_tx_idle())
+        return powerWait;
+    if (wake & WAKE_VLPS)
+        return powerVlps;
+    return powerLls;
+}
+
+/**
+    \brief Sleep until a wake source fires. Call with interrupts masked
+    after checking there is nothing left to do: a pending interrupt
+    still ends the sleep, and runs once the caller unmasks.
+    \return The mode used, see \ref powerMode.
+*/
+uint8_t power_sleep (void)
+{
+    uint8_t mode = power_mode_allowed();
+    uint8_t stopm;
+    uint64_t t0, t1;
+    uint32_t ms;
+
+    t0 = time_us64();
+    stats.time[powerRun] += t0 - lastWake;
+    lastWake = t0;
+    stats.entries[mode]++;
+    if (mode == powerRun)
+        return mode;
+    if (mode == powerWait) {
+        SCB_SCR &= ~SCB_SCR_SLEEPDEEP_MASK;
+        asm volatile ("wfi");
+        t1 = time_us64();
+        stats.time[powerWait] += t1 - t0;
+        wakeStamp = t1;
+        if (SCB_ICSR & SCB_ICSR_PENDSTSET_MASK)
+            wakeStamp -= to_us(SYST_RVR - SYST_CVR);    // Since the reload
+        lastWake = t1;
+        dispatchDue = TRUE;
+        count_wakes();
+        return mode;
+    }
+
+    stopm = (mode == powerLls) ? STOPM_LLS : STOPM_VLPS;
+    if (wake & POWER_WAKE_UART_RX) {
+        UART0_S2 = UARTLP_S2_RXEDGIF_MASK;
+        UART0_BDH |= UARTLP_BDH_RXEDGIE_MASK;
+    }
+    ms = lptmr_ms();
+    SMC_PMCTRL = (SMC_PMCTRL & ~SMC_PMCTRL_STOPM_MASK) | SMC_PMCTRL_STOPM(stopm);
+    (void) SMC_PMCTRL;                  // The write completes before WFI
+    SCB_SCR |= SCB_SCR_SLEEPDEEP_MASK;
+    asm volatile ("wfi");
+    wakeStamp = time_us64();            // The PIT was stopped as well
+    SCB_SCR &= ~SCB_SCR_SLEEPDEEP_MASK;
+    UART0_BDH &= ~UARTLP_BDH_RXEDGIE_MASK;
+    clock_resume();
+    stats.time[mode] += (uint64_t)(lptmr_ms() - ms) * 1000;
+    lastWake = wakeStamp;               // The relock is run time
+    dispatchDue = TRUE;
+    count_wakes();
+    return mode;
+}
+
+/**
+    \brief The main loop is back to work: closes the wake latency of the
+    last sleep. Call first thing in every scheduler pass.
+*/
+void power_dispatch (void)
+{
+    uint32_t primask, us;
+    uint8_t b = 0;
+
+    if (!dispatchDue)
+        return;
+    primask = __irq_save();
+    us = (uint32_t)(time_us64() - wakeStamp);
+    dispatchDue = FALSE;
+    __irq_restore(primask);
+    while (us >= 2 && b != POWER_HIST - 1) {
+        us >>= 1;
+        b++;
+    }
+    stats.latency[b]++;
+}
+
+/**
+    \brief Duty-cycled standby. SysTick, USB and touch stop waking the
+    core, so it stops in VLPS (LLS when the UART RX wake is off) for
+    \p period_ms, runs \p work, and starts over. A WAIT sleep, while
+    the UART still sends, just sleeps again. The wake sources are back
+    as they were on return.
+    \param work Called after each period, may be NULL.
+    \return Periods done: fewer than \p periods when another wake
+    source (a character on the UART) ended a stop early.
+    \note USB stops with the PLL: a host may reset the port meanwhile.
+*/
+uint16_t power_standby (uint16_t period_ms, uint16_t periods, void (*work) (void))
+{
+    uint32_t saved = wake;
+    uint32_t primask;
+    uint16_t n;
+    uint8_t mode = powerWait;
+
+    power_wake_disable(WAKE_WAIT);
+    power_wake_enable(POWER_WAKE_LPTMR);
+    for (n = 0; n != periods; n++) {
+        power_wake_after(period_ms);
+        for (;;) {
+            primask = __irq_save();
+            if (lptmr_alarm_pending())
+                mode = power_sleep();
+            __irq_restore(primask);     // The wake handlers run here
+            power_dispatch();
+            if (!lptmr_alarm_pending() || mode != powerWait)
+                break;
+        }
+        if (lptmr_alarm_pending())      // Woken early: not the alarm
+            break;
+        if (work)
+            work();
+    }
+    power_wake_after(0);
+    power_wake_disable(~saved);
+    power_wake_enable(saved);
+    return n;
+}
+
+/**
+    \brief Copy the counters.
+*/
+void power_stats (power_stat_t *stat)
+{
+    uint32_t primask = __irq_save();
+    *stat = stats;
+    __irq_restore(primask);
+}
+
+/**
+    \brief Print the wake sources and the mode counters on the console.
+*/
+void power_print (void)
+{
+    static const char *const sources[POWER_SOURCES] = {
+        "systick", "usb", "uart rx", "port", "lptmr", "tsi", "llwu", "other"
+    };
+    power_stat_t s;
+    uint8_t i;
+
+    power_stats(&s);
+    iprintf("     wake 0x%02lx, deepest %s\r\n", (unsigned long) wake, names[power_mode_allowed()]);
+    iprintf("  mode    entries        ms\r\n");
+    for (i = 0; i != POWER_MODES; i++)
+        iprintf("  %-5s %9lu %9lu\r\n", names[i], (unsigned long) s.entries[i],
+            (unsigned long)(s.time[i] / 1000));
+    for (i = 0; i != POWER_SOURCES; i++) {
+        if (s.wakes[i])
+            iprintf("  %7s %lu wakes\r\n", sources[i], (unsigned long) s.wakes[i]);
+    }
+    iprintf("  latency");
+    for (i = 0; i != POWER_HIST; i++)
+        iprintf(" %lu", (unsigned long) s.latency[i]);
+    iprintf(" (<2 <4 ... >=128 us)\r\n");
+}
@@ -0,0 +1,72 @@
+/**
+    \file power.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Power management: the main loop sleeps in the deepest mode
+    that every enabled wake source survives.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _POWER_H_
+#define _POWER_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Power
+    @{
+*/
+
+/** \brief Modes, shallowest first. */
+enum powerMode {
+    powerRun,               /**< Not sleeping (nothing allowed a sleep).        */
+    powerWait,              /**< Core stopped, every peripheral runs.           */
+    powerVlps,              /**< Very low power stop: asynchronous wake only.   */
+    powerLls,               /**< Low leakage stop: wake through the LLWU.       */
+    POWER_MODES
+};
+
+/** \brief Wake sources, as bits. */
+enum powerWake {
+    POWER_WAKE_SYSTICK  = 1 << 0,   /**< Core clock: WAIT.                      */
+    POWER_WAKE_USB      = 1 << 1,   /**< Needs the PLL: WAIT.                   */
+    POWER_WAKE_UART_RX  = 1 << 2,   /**< RX edge, first character lost: VLPS.   */
+    POWER_WAKE_PORT     = 1 << 3,   /**< Port interrupt on any pin: VLPS.       */
+    POWER_WAKE_LPTMR    = 1 << 4,   /**< \ref power_wake_after, LLWU module 0: LLS. */
+    POWER_WAKE_TSI      = 1 << 5,   /**< Touch; idle scans run on SysTick: WAIT. */
+    POWER_WAKE_PIN      = 1 << 6    /**< LLWU pins, see \ref power_wake_pin: LLS. */
+};
+
+#define POWER_SOURCES       8       /**< Wake counters: one per \ref powerWake bit, then other. */
+#define POWER_HIST          8       /**< Wake latency buckets: <2, <4 ... <128, >=128 us. */
+
+/** \brief Where the time goes. */
+typedef struct {
+    uint64_t time[POWER_MODES];     /**< Microseconds per mode, run included.     */
+    uint32_t entries[POWER_MODES];  /**< Sleeps per mode; run: sleep refused.     */
+    uint32_t wakes[POWER_SOURCES];  /**< Sleeps ended per source (several may).   */
+    uint32_t latency[POWER_HIST];   /**< Wake to first dispatch, log2 buckets.    */
+} power_stat_t;
+
+#define POWER_EDGE_RISING   1       /**< LLWU pin edge.                         */
+#define POWER_EDGE_FALLING  2
+#define POWER_EDGE_ANY      3
+
+void power_init (void);
+void power_wake_enable (uint32_t sources);
+void power_wake_disable (uint32_t sources);
+void power_wake_pin (uint8_t pin, uint8_t edge);
+void power_wake_after (uint16_t ms);
+uint8_t power_mode_allowed (void);
+uint8_t power_sleep (void);
+void power_dispatch (void);
+uint16_t power_standby (uint16_t period_ms, uint16_t periods, void (*work) (void));
+void power_stats (power_stat_t *stat);
+void power_print (void);
+
+/** @} */ // Power
+
+#endif  // _POWER_H_
@@ -0,0 +1,93 @@
+/**
+    \file profile.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Interrupt profiling. SysTick counts core cycles down from its
+    reload value, so a span is the difference of two reads, corrected
+    once for a wrap; the probe itself adds about 30 cycles.
+    \note To compare flash and RAM placement build twice with
+    -DISR_PROFILE, once adding -DRAMFUNC_IN_FLASH, and compare the
+    Debug menu figures under the same load.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "profile.h"
+
+static prof_stat_t stats[PROF_IDS];
+
+static const char *const names[PROF_IDS] = {
+    "SysTick", "UART0", "TSI0", "USB"
+};
+
+/**
+    \brief Close a span; run by \ref PROF_ISR at handler exit.
+*/
+RAMFUNC void prof_end (prof_span_t *span)
+{
+    uint32_t now = SYST_CVR;
+    uint32_t cycles = span->start - now;
+    prof_stat_t *s = &stats[span->id];
+
+    if (span->start < now)                  // Reloaded in between
+        cycles += SYST_RVR + 1;
+    s->count++;
+    s->total += cycles;
+    if (s->count == 1 || cycles < s->min)
+        s->min = cycles;
+    if (cycles > s->max)
+        s->max = cycles;
+}
+
+/**
+    \brief Read the figures of a handler.
+    \return FALSE when the handler does not exist.
+*/
+uint8_t prof_stats (uint8_t id, prof_stat_t *stat)
+{
+    uint32_t primask;
+
+    if (id >= PROF_IDS)
+        return FALSE;
+    primask = __irq_save();
+    *stat = stats[id];
+    __irq_restore(primask);
+    return TRUE;
+}
+
+/**
+    \brief Start over.
+*/
+void prof_reset (void)
+{
+    uint32_t primask = __irq_save();
+    uint8_t id;
+    for (id = 0; id != PROF_IDS; id++)
+        stats[id].count = stats[id].min = stats[id].max = stats[id].total = 0;
+    __irq_restore(primask);
+}
+
+/**
+    \brief Print cycles per handler on the console.
+*/
+void prof_print (void)
+{
+    prof_stat_t s;
+    uint8_t id;
+
+#ifdef RAMFUNC_IN_FLASH
+    iprintf("  handlers in flash\r\n");
+#else
+    iprintf("  handlers in RAM\r\n");
+#endif
+    iprintf("  handler    count   min  mean   max\r\n");
+    for (id = 0; prof_stats(id, &s); id++) {
+        iprintf("  %-7s %8lu %5lu %5lu %5lu\r\n", names[id], (unsigned long) s.count,
+            (unsigned long) s.min, (unsigned long)(s.count ? s.total / s.count : 0),
+            (unsigned long) s.max);
+    }
+}
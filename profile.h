@@ -0,0 +1,65 @@
+/**
+    \file profile.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Interrupt profiling: core cycles from handler entry to exit,
+    counted on SysTick. Built in with -DISR_PROFILE; without it the
+    probes compile to nothing.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _PROFILE_H_
+#define _PROFILE_H_
+
+#include <stdint.h>
+#include "types.h"
+#include "freedom.h"
+
+/**
+    \addtogroup Profile
+    @{
+*/
+
+/** \brief Profiled handlers. */
+enum profId {
+    profSysTick,
+    profUART0,
+    profTSI0,
+    profUSB,
+    PROF_IDS
+};
+
+/** \brief Cycles spent in one handler. */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t total;             /**< Wraps after about 2^32 cycles (90 s).  */
+} prof_stat_t;
+
+/** \brief Open probe: start count and handler. */
+typedef struct {
+    uint32_t start;
+    uint8_t  id;
+} prof_span_t;
+
+void prof_end (prof_span_t *span);
+uint8_t prof_stats (uint8_t id, prof_stat_t *stat);
+void prof_reset (void);
+void prof_print (void);
+
+#ifdef ISR_PROFILE
+/**
+    \brief First statement of a handler: the span closes on every return
+    path when the probe goes out of scope.
+*/
+#define PROF_ISR(id)    prof_span_t __prof __attribute__ ((cleanup(prof_end))) = { SYST_CVR, (id) }
+#else
+#define PROF_ISR(id)    do { } while (0)
+#endif
+
+/** @} */ // Profile
+
+#endif  // _PROFILE_H_
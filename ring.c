@@ -7,6 +7,7 @@
  * \include LICENSE
  */
 
+#include <string.h>
 #include <freedom.h>
 #include "common.h"
 
@@ -16,7 +17,7 @@ inline void buf_reset(RingBuffer *buf, int size)
     buf->size = size;
 }
 
-inline int buf_len(const RingBuffer *buf)
+RAMFUNC int buf_len(const RingBuffer *buf)
 {
     int len = buf->tail - buf->head;
     if (len < 0)
@@ -25,12 +26,12 @@ inline int buf_len(const RingBuffer *buf)
     return len;
 }
 
-inline int buf_isfull(const RingBuffer *buf)
+RAMFUNC int buf_isfull(const RingBuffer *buf)
 {
     return buf_len(buf) == (buf->size-1);
 }
 
-inline int buf_isempty(const RingBuffer *buf)
+RAMFUNC int buf_isempty(const RingBuffer *buf)
 {
     return buf->head == buf->tail;
 }
@@ -43,15 +44,59 @@ inline int advance(uint16_t i, uint16_t size)
     return i;
 }
 
-inline uint8_t buf_get_byte(RingBuffer *buf)
+RAMFUNC uint8_t buf_get_byte(RingBuffer *buf)
 {
     const uint8_t item = buf->data[buf->head];
     buf->head = advance(buf->head, buf->size);
     return item;
 }
 
-inline void buf_put_byte(RingBuffer *buf, uint8_t val)
+RAMFUNC void buf_put_byte(RingBuffer *buf, uint8_t val)
 {
     buf->data[buf->tail] = val;
     buf->tail = advance(buf->tail, buf->size);
 }
+
+RAMFUNC int buf_free(const RingBuffer *buf)
+{
+    return buf->size - 1 - buf_len(buf);
+}
+
+// Block copy into the buffer, in at most two memcpy() runs.  Returns the
+// number of bytes stored (limited by the free space)
+RAMFUNC int buf_write(RingBuffer *buf, const uint8_t *src, int len)
+{
+    int n, tail = buf->tail;
+
+    if (len > buf_free(buf))
+        len = buf_free(buf);
+    n = buf->size - tail;                   // Room up to the wrap point
+    if (n > len)
+        n = len;
+    memcpy((uint8_t *) &buf->data[tail], src, n);
+    memcpy((uint8_t *) &buf->data[0], src + n, len - n);
+    tail += len;
+    if (tail >= buf->size)
+        tail -= buf->size;
+    buf->tail = tail;
+    return len;
+}
+
+// Block copy out of the buffer.  Returns the number of bytes read
+RAMFUNC int buf_read(RingBuffer *buf, uint8_t *dst, int len)
+{
+    int n, head = buf->head;
+
+    if (len > buf_len(buf))
+        len = buf_len(buf);
+    n = buf->size - head;
+    if (n > len)
+        n = len;
+    memcpy(dst, (uint8_t *) &buf->data[head], n);
+    memcpy(dst + n, (uint8_t *) &buf->data[0], len - n);
+    head += len;
+    if (head >= buf->size)
+        head -= buf->size;
+    buf->head = head;
+    return len;
+}
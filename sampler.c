@@ -0,0 +1,193 @@
+/**
+    \file sampler.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief A0 sampler. The TPM1 overflow starts an A0 conversion; the
+    ADC0 conversion-complete interrupt stores it and, when the scan has
+    asked for one, starts the next scan conversion right away, so it is
+    done long before the next A0 slot (a few microseconds at 24 MHz bus,
+    about 60 at 1 MHz). An A0 slot that finds the ADC busy starts as soon
+    as it frees, and counts as late.
+    \note Blocks are double buffered: a block still held by the consumer
+    when the next one fills is an overrun, and the new block is dropped.
+    \note The PIT belongs to the timebase, and the DMA cannot share the
+    ADC with the software scan, so the pacing is TPM1 plus two short
+    interrupts per sample.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stddef.h>
+#include "freedom.h"
+#include "common.h"
+#include "clock.h"
+#include "sampler.h"
+
+#define IDLE        0xFF            // No conversion in flight
+
+static uint16_t blocks[2][SAMPLER_BLOCK];
+static uint16_t fillCount;
+static uint8_t  fillIdx;
+static volatile uint8_t full;       // Block ready: index + 1, or 0
+static volatile uint8_t current = IDLE;
+static volatile uint8_t scanning;   // The conversion in flight is the scan's
+static volatile uint8_t a0Due;      // A0 slot waiting for the ADC
+static volatile uint8_t scanChannel, scanPending, scanDone;
+static volatile uint16_t scanValue;
+static uint16_t overruns, late;
+
+static inline void start (uint8_t channel, uint8_t scan)
+{
+    current = channel;
+    scanning = scan;
+    ADC0_SC1A = ADC_SC1_AIEN_MASK | ADC_SC1_ADCH(channel);
+}
+
+// TPM1 overflow (FTM1 slot of the vector table)
+void FTM1_IRQHandler() __attribute__((interrupt("IRQ")));
+RAMFUNC void FTM1_IRQHandler(void)
+{
+    TPM1_SC |= TPM_SC_TOF_MASK;
+    if (current == IDLE) {
+        start(SAMPLER_CHANNEL, FALSE);
+    }
+    else {
+        a0Due = TRUE;
+        late++;
+    }
+}
+
+void ADC0_IRQHandler() __attribute__((interrupt("IRQ")));
+RAMFUNC void ADC0_IRQHandler(void)
+{
+    uint16_t v = ADC0_RA;                   // Clears COCO
+
+    if (!scanning) {
+        blocks[fillIdx][fillCount] = v;
+        if (++fillCount == SAMPLER_BLOCK) {
+            fillCount = 0;
+            if (full) {
+                overruns++;                 // Refill the same buffer
+            }
+            else {
+                full = fillIdx + 1;
+                fillIdx ^= 1;
+            }
+        }
+    }
+    else {
+        scanValue = v;
+        scanDone = TRUE;
+    }
+    current = IDLE;
+    if (a0Due) {
+        a0Due = FALSE;
+        start(SAMPLER_CHANNEL, FALSE);
+    }
+    else if (scanPending) {
+        scanPending = FALSE;
+        start(scanChannel, TRUE);
+    }
+}
+
+// TPM1 overflows at SAMPLER_RATE_HZ from the TPM clock of the profile
+static void sampler_clock (const clock_info_t *clk)
+{
+    uint32_t ticks = clk->periph / SAMPLER_RATE_HZ;
+    uint8_t ps = 0;
+
+    while ((ticks >> ps) > 0x10000)
+        ps++;
+    TPM1_MOD = (ticks >> ps) - 1;           // Latched on the next overflow
+    TPM1_SC = (TPM1_SC & ~TPM_SC_PS_MASK) | TPM_SC_PS(ps);
+}
+
+/**
+    \brief Start pacing A0. The ADC must be configured for software
+    triggers; from here on every conversion goes through this module.
+*/
+void sampler_init (void)
+{
+    SIM_SCGC6 |= SIM_SCGC6_TPM1_MASK;
+    TPM1_SC = 0;
+    TPM1_CNT = 0;
+    sampler_clock(clock_info());
+    clock_notify(sampler_clock);
+    fillCount = 0;
+    fillIdx = 0;
+    full = 0;
+    current = IDLE;
+    enable_irq(INT_ADC0);
+    enable_irq(INT_TPM1);
+    TPM1_SC |= TPM_SC_TOF_MASK | TPM_SC_TOIE_MASK | TPM_SC_CMOD(1);
+}
+
+/**
+    \return The oldest full block of A0 samples, or NULL. It stays valid
+    until \ref sampler_release.
+*/
+const uint16_t *sampler_block (void)
+{
+    uint8_t f = full;
+    return f ? blocks[f - 1] : NULL;
+}
+
+/**
+    \brief Hand the block back to the sampler.
+*/
+void sampler_release (void)
+{
+    full = 0;
+}
+
+/**
+    \brief Convert one channel for the scan, as soon as the ADC is free.
+    \param channel ADC input, e.g. ADC_AD9.
+*/
+void sampler_convert (uint8_t channel)
+{
+    uint32_t primask = __irq_save();
+
+    scanDone = FALSE;
+    if (current == IDLE) {
+        start(channel, TRUE);
+    }
+    else {
+        scanChannel = channel;
+        scanPending = TRUE;
+    }
+    __irq_restore(primask);
+}
+
+/**
+    \return TRUE once the conversion asked by \ref sampler_convert is done.
+*/
+uint8_t sampler_ready (void)
+{
+    return scanDone;
+}
+
+/**
+    \return Result of the last scan conversion.
+*/
+uint16_t sampler_result (void)
+{
+    return scanValue;
+}
+
+/**
+    \return Blocks dropped because the previous one was still held.
+*/
+uint16_t sampler_overruns (void)
+{
+    return overruns;
+}
+
+/**
+    \return A0 slots that found a scan conversion in flight.
+*/
+uint16_t sampler_late (void)
+{
+    return late;
+}
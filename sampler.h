@@ -0,0 +1,40 @@
+/**
+    \file sampler.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief A0 sampler: TPM1 paces A0 conversions at \ref SAMPLER_RATE_HZ
+    into blocks for the tone detector, and the software scan of the
+    other inputs runs its conversions in the gaps.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _SAMPLER_H_
+#define _SAMPLER_H_
+
+#include <stdint.h>
+#include "types.h"
+#include "tone.h"
+
+/**
+    \addtogroup Sampler
+    @{
+*/
+
+#define SAMPLER_RATE_HZ     2560    /**< 50 and 60 Hz fall on bins 5 and 6.    */
+#define SAMPLER_BLOCK       TONE_BLOCK  /**< Samples per block.                */
+#define SAMPLER_CHANNEL     8       /**< A0 is ADC0_SE8 (PTB0).                */
+
+void sampler_init (void);
+const uint16_t *sampler_block (void);
+void sampler_release (void);
+void sampler_convert (uint8_t channel);
+uint8_t sampler_ready (void);
+uint16_t sampler_result (void);
+uint16_t sampler_overruns (void);
+uint16_t sampler_late (void);
+
+/** @} */ // Sampler
+
+#endif  // _SAMPLER_H_
@@ -0,0 +1,137 @@
+/**
+    \file screen.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Differential terminal renderer. The model of the terminal is
+    a 32-bit hash per row (160 bytes instead of a full character shadow);
+    a changed row costs its text plus about 10 bytes of escape codes, an
+    unchanged row costs nothing. Output that did not come from here
+    (iprintf, trace and monitor dumps, debug prints) is noticed from the
+    console byte count, and the next frame redraws everything.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "console.h"
+#include "screen.h"
+
+#define HASH_BASIS  2166136261u     // FNV-1a
+#define HASH_PRIME  16777619u
+#define HASH_NONE   0               // Row content unknown
+
+static uint32_t shown[SCREEN_ROWS];     // What the terminal displays
+static uint8_t shownRows;               // Rows drawn by the last frame
+static uint8_t clear;                   // Erase the terminal first
+static uint32_t written;                // Console bytes after our last frame
+
+static char rowText[SCREEN_COLS];
+static fmt_t rowFmt;
+static uint8_t row;                     // Rows of the frame so far
+static uint8_t open;                    // rowFmt holds a row
+
+static char outText[128];
+static fmt_t out;
+
+static uint32_t hash (const char *s, uint16_t len)
+{
+    uint32_t h = HASH_BASIS;
+    while (len--)
+        h = (h ^ (uint8_t) *s++) * HASH_PRIME;
+    return (h == HASH_NONE) ? 1 : h;
+}
+
+// Cursor to the start of a row (1-based on the terminal)
+static void locate (uint8_t r)
+{
+    fmt_str(&out, "\033[");
+    fmt_u32(&out, r + 1, 0, ' ');
+    fmt_str(&out, ";1H");
+}
+
+// Compare the row just built with the terminal and send it if needed
+static void commit (void)
+{
+    uint32_t h;
+
+    if (!open)
+        return;
+    open = FALSE;
+    if (row >= SCREEN_ROWS)
+        return;
+    h = hash(rowText, rowFmt.len);
+    if (h != shown[row]) {
+        locate(row);
+        for (uint16_t i = 0; i != rowFmt.len; i++)
+            fmt_char(&out, rowText[i]);
+        fmt_str(&out, "\033[K");            // Erase what the old row left
+        shown[row] = h;
+    }
+    row++;
+}
+
+/**
+    \brief Forget what the terminal shows: the next frame clears the
+    screen and draws every row. \ref screen_begin does it by itself
+    when the console carried other output since the last frame.
+*/
+void screen_invalidate (void)
+{
+    uint8_t r;
+    for (r = 0; r != SCREEN_ROWS; r++)
+        shown[r] = HASH_NONE;
+    shownRows = 0;
+    clear = TRUE;
+}
+
+/**
+    \brief Start a frame.
+*/
+void screen_begin (void)
+{
+    fflush(stdout);                         // Pending iprintf text counts
+    if (console_written() != written)
+        screen_invalidate();
+    fmt_init(&out, outText, sizeof(outText));
+    if (clear) {
+        fmt_str(&out, "\033[2J");
+        clear = FALSE;
+    }
+    row = 0;
+    open = FALSE;
+}
+
+/**
+    \brief Start the next row of the frame.
+    \return Where to write the text of the row, without line ending.
+*/
+fmt_t *screen_row (void)
+{
+    commit();
+    fmt_init_string(&rowFmt, rowText, sizeof(rowText));
+    open = TRUE;
+    return &rowFmt;
+}
+
+/**
+    \brief Finish the frame: erase rows left over from a longer frame and
+    send everything with as few writes as the buffer allows.
+*/
+void screen_end (void)
+{
+    uint8_t r;
+
+    commit();
+    for (r = row; r < shownRows; r++) {
+        locate(r);
+        fmt_str(&out, "\033[K");
+        shown[r] = hash("", 0);
+    }
+    shownRows = row;
+    locate(row);                            // Park the cursor below
+    fmt_flush(&out);
+    written = console_written();
+}
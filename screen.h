@@ -0,0 +1,35 @@
+/**
+    \file screen.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Differential terminal renderer: a frame is built row by row
+    and only the rows that differ from what the terminal already shows
+    are sent, with ANSI cursor positioning.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _SCREEN_H_
+#define _SCREEN_H_
+
+#include <stdint.h>
+#include "types.h"
+#include "fmt.h"
+
+/**
+    \addtogroup Screen
+    @{
+*/
+
+#define SCREEN_ROWS     40      /**< Rows tracked; later rows are dropped.     */
+#define SCREEN_COLS     64      /**< Longest row; the rest is cut.             */
+
+void screen_invalidate (void);
+void screen_begin (void);
+fmt_t *screen_row (void);
+void screen_end (void);
+
+/** @} */ // Screen
+
+#endif  // _SCREEN_H_
@@ -0,0 +1,116 @@
+/**
+    \file sensors.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Sensor snapshot store protected by a sequence lock.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include "freedom.h"
+#include "common.h"
+#include "sensors.h"
+
+static sensor_snapshot_t snapshot;
+static volatile uint32_t snapshot_seq;  /**< Odd while a writer is active. */
+
+/**
+    \brief Open a write section.
+    Writers mask interrupts for the few cycles of the update so that two
+    producers (a protothread and an interrupt handler) never interleave;
+    readers are never blocked by this.
+    \return Previous PRIMASK, to be handed to write_end().
+*/
+static inline uint32_t write_begin (void)
+{
+    uint32_t primask = __irq_save();
+    snapshot_seq++;
+    __dmb();
+    return primask;
+}
+
+static inline void write_end (uint32_t primask)
+{
+    snapshot.stamp = sysTicks;
+    __dmb();
+    snapshot_seq++;
+    __irq_restore(primask);
+}
+
+/**
+    \brief Publish a complete scan of the analog inputs.
+    \param adc Array of \ref SENSOR_ADC_CHANNELS conversions (A0 first).
+*/
+void sensor_publish_adc (const uint16_t *adc)
+{
+    uint32_t i, primask = write_begin();
+    for (i = 0; i != SENSOR_ADC_CHANNELS; i++) {
+        snapshot.adc[i] = adc[i];
+    }
+    snapshot.seqAdc++;
+    write_end(primask);
+}
+
+/**
+    \brief Publish the three accelerometer axes as one sample.
+*/
+void sensor_publish_accel (int16_t x, int16_t y, int16_t z)
+{
+    uint32_t primask = write_begin();
+    snapshot.accel[0] = x;
+    snapshot.accel[1] = y;
+    snapshot.accel[2] = z;
+    snapshot.seqAccel++;
+    write_end(primask);
+}
+
+/**
+    \brief Publish both touch electrodes as one sample.
+*/
+void sensor_publish_touch (int16_t x, int16_t y)
+{
+    uint32_t primask = write_begin();
+    snapshot.touch[0] = x;
+    snapshot.touch[1] = y;
+    snapshot.seqTouch++;
+    write_end(primask);
+}
+
+/**
+    \brief Take a coherent copy of the snapshot.
+    Retries while a writer was active or the sequence changed during the
+    copy, so every field comes from the same publish generation.
+    \param copy Destination of the snapshot.
+    \note Safe to call from thread or interrupt context.
+*/
+void sensor_read (sensor_snapshot_t *copy)
+{
+    uint32_t seq;
+    do {
+        seq = snapshot_seq;
+        __dmb();
+        *copy = snapshot;
+        __dmb();
+    } while ((seq & 1) || (seq != snapshot_seq));
+}
+
+/**
+    \brief Get one value of a snapshot by its menu index.
+    \param snap Snapshot taken with sensor_read().
+    \param idx Index, see \ref sensorIdx.
+    \return Value sign-extended to 32 bits, 0 if the index is invalid.
+*/
+int32_t sensor_value (const sensor_snapshot_t *snap, uint8_t idx)
+{
+    if (idx <= idxADC5) {
+        return snap->adc[idx - idxADC0];
+    }
+    else if (idx <= idxAccelZ) {
+        return snap->accel[idx - idxAccelX];
+    }
+    else if (idx <= idxTouchDataY) {
+        return snap->touch[idx - idxTouchDataX];
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+/**
+    \file sensors.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Sensor snapshot store. Producers (protothreads or interrupt
+    handlers) publish whole scans, consumers get a coherent copy through
+    a sequence lock without disabling interrupts.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _SENSORS_H_
+#define _SENSORS_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Sensors
+    @{
+*/
+
+#define SENSOR_ADC_CHANNELS     6   /**< Analog inputs A0..A5.           */
+#define SENSOR_ACCEL_AXES       3   /**< Accelerometer X, Y, Z.          */
+#define SENSOR_TOUCH_CHANNELS   2   /**< TSI channels 9 and 10.          */
+
+/** \brief Index of every value held in a snapshot (menu order). */
+enum sensorIdx
+{
+    idxADC0 = 0,
+    idxADC1,
+    idxADC2,
+    idxADC3,
+    idxADC4,
+    idxADC5,
+    idxAccelX,
+    idxAccelY,
+    idxAccelZ,
+    idxTouchDataX,
+    idxTouchDataY
+};
+
+#define SENSOR_LAST idxTouchDataY   /**< Last valid index of \ref sensorIdx. */
+
+/**
+    \brief A coherent copy of every sensor of the board.
+    Each group carries its own sequence number, incremented on every
+    publish, so a consumer can tell whether a group was refreshed since
+    its last read.
+*/
+typedef struct {
+    uint32_t stamp;                             /**< sysTicks of the last publish. */
+    uint16_t seqAdc;                            /**< ADC scans published.          */
+    uint16_t seqAccel;                          /**< Accelerometer reads published.*/
+    uint16_t seqTouch;                          /**< Touch reads published.        */
+    uint16_t adc[SENSOR_ADC_CHANNELS];          /**< Raw 16-bit conversions.       */
+    int16_t  accel[SENSOR_ACCEL_AXES];          /**< Signed 14-bit counts.         */
+    int16_t  touch[SENSOR_TOUCH_CHANNELS];      /**< Counts over baseline.         */
+} sensor_snapshot_t;
+
+void sensor_publish_adc (const uint16_t *adc);
+void sensor_publish_accel (int16_t x, int16_t y, int16_t z);
+void sensor_publish_touch (int16_t x, int16_t y);
+void sensor_read (sensor_snapshot_t *copy);
+int32_t sensor_value (const sensor_snapshot_t *snap, uint8_t idx);
+
+/** @} */ // Sensors
+
+#endif  // _SENSORS_H_
@@ -0,0 +1,121 @@
+/**
+    \file stream.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Sample streaming. Producers fill a block from the large class
+    of the block pools (a DMA transfer can write the payload directly)
+    and commit it; the USB controller reads it in place and the block
+    comes back to the pool when the host has it.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <string.h>
+#include "freedom.h"
+#include "common.h"
+#include "pool.h"
+#include "stream.h"
+#include "timebase.h"
+
+static uint32_t seq;
+static uint16_t dropped;
+
+// Snapshot producer state
+#define SNAP_RECORD     (SENSOR_LAST + 1)       // int16_t values per record
+static stream_block_t *current;
+
+// Back to the pool; called by the USB interrupt once the host has the block
+static RAMFUNC void release (uint8_t *data)
+{
+    pool_free(data);
+}
+
+/**
+    \brief Register with the USB stream endpoint.
+*/
+void stream_init (void)
+{
+    seq = 0;
+    dropped = 0;
+    current = NULL;
+    usb_stream_callback(release);
+}
+
+/**
+    \brief Take a free block.
+    \return The block, or NULL when every block is queued for the host.
+*/
+stream_block_t *stream_acquire (void)
+{
+    stream_block_t *block = pool_alloc(sizeof(stream_block_t));
+
+    if (block != NULL) {
+        block->stamp = time_us32();
+        block->bytes = 0;
+        block->kind = STREAM_KIND_SNAPSHOT;
+        block->spare = 0;
+    }
+    return block;
+}
+
+/**
+    \brief Send a block. It returns to the pool when the host has read
+    it, or at once if it cannot be queued (the sequence gap tells).
+    \param bytes Payload bytes used.
+*/
+void stream_commit (stream_block_t *block, uint16_t bytes)
+{
+    block->seq = seq++;
+    block->bytes = bytes;
+    block->dropped = dropped;
+    dropped = 0;
+    if (usb_stream_submit((uint8_t *) block, STREAM_BLOCK_SIZE) < 0)
+        release((uint8_t *) block);
+}
+
+/**
+    \brief Send one record in a block of its own, beside the snapshots.
+    \param kind See \ref streamKind.
+    \return 0, or -1 when no block is free or the record does not fit.
+*/
+int stream_record (uint16_t kind, const void *data, uint16_t len)
+{
+    stream_block_t *block;
+
+    if (len > STREAM_PAYLOAD)
+        return -1;
+    block = stream_acquire();
+    if (block == NULL)
+        return -1;
+    block->kind = kind;
+    memcpy(block->data, data, len);
+    stream_commit(block, len);
+    return 0;
+}
+
+/**
+    \brief Append a sensor snapshot (every channel as int16_t) to the
+    current block, sending it when full.
+*/
+void stream_snapshot (const sensor_snapshot_t *snap)
+{
+    int16_t *rec;
+    uint8_t ch;
+
+    if (current == NULL) {
+        current = stream_acquire();
+        if (current == NULL) {
+            dropped++;
+            return;
+        }
+    }
+    rec = (int16_t *) &current->data[current->bytes];
+    for (ch = 0; ch != SNAP_RECORD; ch++)
+        rec[ch] = (int16_t) sensor_value(snap, ch);
+    current->bytes += SNAP_RECORD * sizeof(int16_t);
+    if (current->bytes + SNAP_RECORD * sizeof(int16_t) > STREAM_PAYLOAD) {
+        stream_commit(current, current->bytes);
+        current = NULL;
+    }
+}
@@ -0,0 +1,58 @@
+/**
+    \file stream.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Sample streaming over the vendor bulk interface of the USB
+    device: fixed-size blocks with a sequence header, sent without copy.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _STREAM_H_
+#define _STREAM_H_
+
+#include <stdint.h>
+#include "types.h"
+#include "sensors.h"
+
+/**
+    \addtogroup Stream
+    @{
+*/
+
+#define STREAM_BLOCK_SIZE   512     /**< Multiple of 64, fits POOL_BLOCK_SIZE. */
+#define STREAM_HEADER_SIZE  16
+#define STREAM_PAYLOAD      (STREAM_BLOCK_SIZE - STREAM_HEADER_SIZE)
+
+/**
+    \brief One block as seen by the host. The sequence number advances
+    for every block produced, sent or not, so a gap on the host side is
+    a drop; 'dropped' counts the samples lost before this block.
+*/
+typedef struct {
+    uint32_t seq;                   /**< Block counter.                         */
+    uint32_t stamp;                 /**< time_us32() of the first sample.       */
+    uint16_t bytes;                 /**< Payload bytes used.                    */
+    uint16_t dropped;               /**< Samples lost since the previous block. */
+    uint16_t kind;                  /**< Payload layout, see \ref streamKind.   */
+    uint16_t spare;
+    uint8_t  data[STREAM_PAYLOAD];
+} stream_block_t;
+
+/** \brief Payload layouts. */
+enum streamKind {
+    STREAM_KIND_SNAPSHOT,           /**< int16_t per channel, record after record. */
+    STREAM_KIND_POWER,              /**< One power_stat_t (power.h).             */
+    STREAM_KIND_TONE                /**< One tone_report_t (tone.h).             */
+};
+
+void stream_init (void);
+stream_block_t *stream_acquire (void);
+void stream_commit (stream_block_t *block, uint16_t bytes);
+void stream_snapshot (const sensor_snapshot_t *snap);
+int stream_record (uint16_t kind, const void *data, uint16_t len);
+
+/** @} */ // Stream
+
+#endif  // _STREAM_H_
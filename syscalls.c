@@ -10,6 +10,7 @@
 #include <freedom.h>
 #include <sys/stat.h>
 #include "common.h"
+#include "console.h"
 
 int _close(int file) { return -1; }
 int _isatty(int file) { return 1; }
@@ -24,7 +25,7 @@ int _fstat(int file, struct stat *st)
 int _write(int file, char *p, int len)
 {
     switch(file) {
-     case 1:        return uart_write(p, len);              // stdout
+     case 1:        return console_write(p, len);           // stdout
      case 2:        return uart_write_err(p,len);           // stderr
      default:       return -1;
     }
@@ -32,19 +33,10 @@ int _write(int file, char *p, int len)
 
 int _read(int file, char *p, int len)
 {
-    return uart_read(p, len);
+    return console_read(p, len);
 }
 
-// ------------------------------------------------------------------------------------
-// _sbrk(len) -- Allocate space on the heap
-//
-static char *heap_end = (char *) __heap_start;
-
-char *_sbrk(int incr)
-{
-    heap_end += incr;                   // TODO:  check for collisions with the stack
-    return (heap_end - incr);
-}
+// _sbrk() is in memory.c, with the heap and stack accounting
 
 // Signal handler (fault)
 int _kill(int pid, int sig)
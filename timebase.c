@@ -0,0 +1,82 @@
+/**
+    \file timebase.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Microsecond timebase. The high word of \ref time_us64 is
+    counted by the channel 1 interrupt; readers never mask interrupts,
+    they read again when that word moved under them, and account for a
+    wrap still pending when they run with the interrupt masked.
+    \note The PIT runs on the bus clock, so the divider follows the clock
+    profile (24 MHz or 1 MHz). It stops in VLPS and LLS: time does not
+    advance while the core is in those modes.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include "freedom.h"
+#include "common.h"
+#include "clock.h"
+#include "timebase.h"
+
+static volatile uint32_t wraps;         // High word
+
+void PIT_IRQHandler() __attribute__((interrupt("IRQ")));
+void PIT_IRQHandler(void)
+{
+    PIT_TFLG1 = PIT_TFLG_TIF_MASK;
+    wraps++;
+}
+
+// Channel 0 expires once per microsecond of the new bus clock
+static void pit_clock (const clock_info_t *clk)
+{
+    PIT_LDVAL0 = clk->bus / 1000000 - 1;    // Next period on
+}
+
+/**
+    \brief Start the count from zero. Call once the clock is set.
+*/
+void timebase_init (void)
+{
+    SIM_SCGC6 |= SIM_SCGC6_PIT_MASK;
+    PIT_MCR = 0;                            // Module on, runs in debug
+    PIT_TCTRL0 = 0;
+    PIT_TCTRL1 = 0;
+    pit_clock(clock_info());
+    PIT_LDVAL1 = 0xFFFFFFFF;
+    PIT_TFLG1 = PIT_TFLG_TIF_MASK;
+    wraps = 0;
+    PIT_TCTRL1 = PIT_TCTRL_CHN_MASK | PIT_TCTRL_TIE_MASK | PIT_TCTRL_TEN_MASK;
+    PIT_TCTRL0 = PIT_TCTRL_TEN_MASK;
+    clock_notify(pit_clock);
+    enable_irq(INT_PIT);
+}
+
+/**
+    \brief Microseconds since \ref timebase_init; does not wrap.
+*/
+uint64_t time_us64 (void)
+{
+    uint32_t hi, lo, pending;
+
+    do {
+        hi = wraps;
+        lo = ~PIT_CVAL1;
+        pending = PIT_TFLG1 & PIT_TFLG_TIF_MASK;
+        if (pending)                        // Wrapped, interrupt not taken
+            lo = ~PIT_CVAL1;
+    } while (hi != wraps);
+    return ((uint64_t)(hi + pending) << 32) | lo;
+}
+
+/**
+    \brief Busy wait, to the microsecond; below 71 minutes.
+*/
+void delay_us (uint32_t us)
+{
+    uint32_t start = time_us32();
+
+    while (time_us32() - start < us)
+        ;
+}
@@ -0,0 +1,40 @@
+/**
+    \file timebase.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Microsecond timebase on the two PIT channels chained: channel
+    0 divides the bus clock down to 1 MHz, channel 1 counts microseconds
+    over 32 bits and its interrupt extends the count to 64.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _TIMEBASE_H_
+#define _TIMEBASE_H_
+
+#include <stdint.h>
+#include "types.h"
+#include "freedom.h"
+
+/**
+    \addtogroup Timebase
+    @{
+*/
+
+void timebase_init (void);
+uint64_t time_us64 (void);
+void delay_us (uint32_t us);
+
+/**
+    \brief Microseconds, wrapping every 71 minutes: one register read,
+    for stamps and short intervals from any context.
+*/
+static inline uint32_t time_us32 (void)
+{
+    return ~PIT_CVAL1;                  // Counts down from 0xFFFFFFFF
+}
+
+/** @} */ // Timebase
+
+#endif  // _TIMEBASE_H_
@@ -0,0 +1,180 @@
+/**
+    \file tone.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Tone detector. Every sample runs through one Goertzel filter
+    per bin (about 10 cycles each); once per block the bin powers are
+    compared against the AC energy of the block, so detection does not
+    depend on the signal level. A 64-sample block with three bins costs
+    about 2.5k cycles per 64 samples, a real FFT of the same block about
+    15k.
+    \note A bin needs fs > 2.freq: bins above Nyquist for the rate given
+    to \ref tone_init are left disabled. Bins are fs/TONE_BLOCK apart, so
+    telling 50 Hz from 60 Hz needs fs <= 2560 Hz with 256-sample blocks.
+    A0 comes from the sampler (sampler.c) at \ref SAMPLER_RATE_HZ.
+    \note The Goertzel state of a bin at w grows to |X|/sin(w), 8 times
+    |X| for 50 Hz at 2560 Hz: low bins get as many extra bits of shift
+    before the power, so a full-scale tone does not clamp.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include "dsp.h"
+#include "tone.h"
+
+// State scaling for the power, see dsp_goertzel_q15_power(). With this
+// shift a pure tone leaves 1/32 of the block energy in its bin for any
+// block length; each bin adds its own headroom on top
+#define TONE_SHIFT      (TONE_LOG2_BLOCK + 2)
+
+// Minimum bin power (about 1% of full scale) to avoid firing on noise
+#define TONE_FLOOR      64
+
+/** \brief Frequencies of the bank, Hz, indexed by bin. */
+static const uint16_t toneFreq[TONE_BINS] = { 50, 60, 1000 };
+
+static dsp_goertzel_q15_t bank[TONE_BINS];
+static uint8_t  headroom[TONE_BINS];    // Extra shift, see tone_headroom()
+static uint32_t power[TONE_BINS];       // Last block, see tone_power()
+static uint32_t energy;                 // Sum of x^2 / TONE_BLOCK, Q30
+static int32_t  sum;                    // Raw sum, for the DC estimate
+static uint16_t dc;                     // Mean of the previous block
+static uint16_t count;                  // Samples in the current block
+static uint8_t  enabled, detected, events;
+
+/**
+    \brief Bits of headroom for the Goertzel state of a bin, from the
+    coefficient (2.cos(w), Q14). TONE_SHIFT leaves a full-scale tone at
+    2^12, two bits below the clamp; one of them is kept as margin for
+    non-sinusoidal input, so this is the smallest h with
+    2^(h + 1).sin(w) >= 1.
+*/
+static uint8_t tone_headroom (q15_t coeff)
+{
+    int32_t c = coeff >> 1;                     // cos(w), Q14
+    uint32_t sin2 = (1UL << 28) - (uint32_t)(c * c);   // sin^2(w), Q28
+    uint8_t h = 0;
+
+    while (sin2 != 0 && h < 8 && (sin2 << (2 * h + 2)) < (1UL << 28))
+        h++;
+    return h;
+}
+
+/**
+    \brief Configure the bank for a sample rate and clear its state.
+    \param fs Rate at which \ref tone_feed will be called, Hz.
+*/
+void tone_init (uint32_t fs)
+{
+    uint8_t k;
+    enabled = detected = events = 0;
+    for (k = 0; k != TONE_BINS; k++) {
+        if (2 * (uint32_t) toneFreq[k] < fs) {
+            bank[k].coeff = dsp_goertzel_coeff(toneFreq[k], fs, TONE_BLOCK);
+            headroom[k] = tone_headroom(bank[k].coeff);
+            enabled |= 1 << k;
+        }
+        dsp_goertzel_q15_reset(&bank[k]);
+        power[k] = 0;
+    }
+    energy = 0;
+    sum = 0;
+    dc = 32768;
+    count = 0;
+}
+
+/**
+    \brief Close a block: update powers, detection flags and events.
+*/
+static void tone_close (void)
+{
+    uint8_t k, state = 0;
+
+    // On above half of the energy a pure tone would leave in the bin,
+    // off below a quarter
+    for (k = 0; k != TONE_BINS; k++) {
+        uint8_t bit = 1 << k;
+        uint8_t h2 = 2 * headroom[k];
+        uint32_t p = dsp_goertzel_q15_power(&bank[k], TONE_SHIFT + headroom[k]);
+
+        // Reported at TONE_SHIFT, saturated; compared at the bin's scale
+        power[k] = (p > (UINT32_MAX >> h2)) ? UINT32_MAX : p << h2;
+        dsp_goertzel_q15_reset(&bank[k]);
+        if (!(enabled & bit) || p < (TONE_FLOOR >> h2)) continue;
+        if (p >= (energy >> (6 + h2)) || ((detected & bit) && p >= (energy >> (7 + h2))))
+            state |= bit;
+    }
+    events |= state ^ detected;
+    detected = state;
+
+    dc = (uint16_t)(sum >> TONE_LOG2_BLOCK);
+    sum = 0;
+    energy = 0;
+    count = 0;
+}
+
+/**
+    \brief Feed one ADC sample.
+    \param sample Conversion result, 16-bit unsigned.
+*/
+void tone_feed (uint16_t sample)
+{
+    uint8_t k;
+    q15_t x = dsp_sat_q15((int32_t) sample - dc);
+
+    sum += sample;
+    energy += ((int32_t) x * x) >> TONE_LOG2_BLOCK;
+    for (k = 0; k != TONE_BINS; k++) {
+        if (enabled & (1 << k))
+            dsp_goertzel_q15(&bank[k], x);
+    }
+    if (++count == TONE_BLOCK)
+        tone_close();
+}
+
+/**
+    \brief Feed a buffer of ADC samples, e.g. a burst captured at a
+    faster rate than the scan.
+*/
+void tone_feed_block (const uint16_t *samples, uint16_t n)
+{
+    while (n--)
+        tone_feed(*samples++);
+}
+
+/**
+    \return Bitmask of the bins usable at the configured rate.
+*/
+uint8_t tone_enabled (void)
+{
+    return enabled;
+}
+
+/**
+    \return Bitmask of the bins detected in the last block.
+*/
+uint8_t tone_detected (void)
+{
+    return detected;
+}
+
+/**
+    \return Bitmask of the bins that changed state since the last call.
+*/
+uint8_t tone_events (void)
+{
+    uint8_t e = events;
+    events = 0;
+    return e;
+}
+
+/**
+    \param bin Index, e.g. \ref TONE_MAINS_50.
+    \return Power of the bin in the last block, |X|^2 / 2^(2.TONE_SHIFT)
+    (a full-scale tone gives 2^24), saturated.
+*/
+uint32_t tone_power (uint8_t bin)
+{
+    return (bin < TONE_BINS) ? power[bin] : 0;
+}
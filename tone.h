@@ -0,0 +1,49 @@
+/**
+    \file tone.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Tone detector: a bank of Goertzel filters run over fixed-size
+    blocks of one ADC channel.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _TONE_H_
+#define _TONE_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Tone
+    @{
+*/
+
+#define TONE_LOG2_BLOCK 8       /**< log2 of the block length.                 */
+#define TONE_BLOCK      (1 << TONE_LOG2_BLOCK)  /**< Samples per block.        */
+#define TONE_BINS       3       /**< Filters in the bank.                      */
+
+#define TONE_MAINS_50   0       /**< Bin index: 50 Hz mains hum.               */
+#define TONE_MAINS_60   1       /**< Bin index: 60 Hz mains hum.               */
+#define TONE_PILOT      2       /**< Bin index: 1 kHz pilot tone.              */
+
+/** \brief Detector state as streamed on a change (STREAM_KIND_TONE). */
+typedef struct {
+    uint32_t power[TONE_BINS];  /**< See \ref tone_power.                    */
+    uint8_t  detected;          /**< See \ref tone_detected.                 */
+    uint8_t  changed;           /**< Bins that changed state in this block.  */
+    uint16_t spare;
+} tone_report_t;
+
+void tone_init (uint32_t fs);
+void tone_feed (uint16_t sample);
+void tone_feed_block (const uint16_t *samples, uint16_t n);
+uint8_t tone_enabled (void);
+uint8_t tone_detected (void);
+uint8_t tone_events (void);
+uint32_t tone_power (uint8_t bin);
+
+/** @} */ // Tone
+
+#endif  // _TONE_H_
@@ -0,0 +1,561 @@
+/**
+    \file dsptest.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Host tests of the DSP kernels (dsp.c built natively). Every
+    kernel is run against a double-precision reference that rounds at
+    the same points, and must match it bit for bit; FFT and Goertzel are
+    also held to the exact transform within a bound. A last pass times
+    each kernel on the host.
+    \note Usage: dsptest [-q]; -q skips the timings. Exit status is the
+    number of failed checks.
+    \note Host time only tracks regressions: the M0+ cycle counts are
+    the estimates in dsp.c.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "dsp.h"
+#include "tone.h"
+
+static int failures, checks;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        checks++;                                                           \
+        if (!(cond)) {                                                      \
+            failures++;                                                     \
+            if (failures <= 20) {                                           \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__);                 \
+                printf(__VA_ARGS__);                                        \
+                printf("\n");                                               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+// Deterministic input (xorshift32)
+static uint32_t seed = 0x1234567;
+
+static uint32_t rnd (void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static q15_t rnd_q15 (void)
+{
+    return (q15_t) rnd();
+}
+
+static double sat (double x, double lo, double hi)
+{
+    return (x > hi) ? hi : (x < lo) ? lo : x;
+}
+
+// Integer products below 2^53 are exact in double, so floor() of the
+// sum is the arithmetic shift of the fixed-point accumulator
+static double q15_out (double acc, int shift)
+{
+    return sat(floor(acc / ldexp(1, shift)), INT16_MIN, INT16_MAX);
+}
+
+static double q31_out (__int128 acc, int shift)
+{
+    acc >>= shift;
+    if (acc > INT32_MAX) return INT32_MAX;
+    if (acc < INT32_MIN) return INT32_MIN;
+    return (double) acc;
+}
+
+// -----------------------------------------------------------------------------
+
+static void test_fir (void)
+{
+    enum { TAPS = 13, N = 2000 };
+    q15_t coeffs[TAPS], state[2 * TAPS];
+    double hist[TAPS] = { 0 };
+    dsp_fir_q15_t f;
+    int i, k;
+
+    for (k = 0; k != TAPS; k++)
+        coeffs[k] = rnd_q15() / 4;              // Some outputs saturate
+    dsp_fir_q15_init(&f, coeffs, state, TAPS);
+
+    for (i = 0; i != N; i++) {
+        q15_t x = (i < 64) ? ((i & 1) ? INT16_MIN : INT16_MAX) : rnd_q15();
+        double acc = 0, want;
+        q15_t got;
+
+        memmove(hist + 1, hist, (TAPS - 1) * sizeof(double));
+        hist[0] = x;
+        for (k = 0; k != TAPS; k++)
+            acc += coeffs[k] * hist[k];
+        want = q15_out(acc, 15);
+        got = dsp_fir_q15(&f, x);
+        CHECK(got == want, "fir q15 sample %d: %d, expected %.0f", i, got, want);
+    }
+}
+
+static void test_fir_q31 (void)
+{
+    enum { TAPS = 9, N = 1000 };
+    q31_t coeffs[TAPS], state[2 * TAPS];
+    int64_t hist[TAPS] = { 0 };
+    dsp_fir_q31_t f;
+    int i, k;
+
+    for (k = 0; k != TAPS; k++)
+        coeffs[k] = (q31_t) rnd() / 8;          // Sum of |b| below 2
+    dsp_fir_q31_init(&f, coeffs, state, TAPS);
+
+    for (i = 0; i != N; i++) {
+        q31_t x = (i < 32) ? ((i & 1) ? INT32_MIN : INT32_MAX) : (q31_t) rnd();
+        __int128 acc = 0;
+        double want;
+        q31_t got;
+
+        memmove(hist + 1, hist, (TAPS - 1) * sizeof(int64_t));
+        hist[0] = x;
+        for (k = 0; k != TAPS; k++)
+            acc += (__int128) coeffs[k] * hist[k];
+        want = q31_out(acc, 31);
+        got = dsp_fir_q31(&f, x);
+        CHECK(got == want, "fir q31 sample %d: %d, expected %.0f", i, got, want);
+    }
+}
+
+// Two second order low-pass sections, fc = fs/20, Q(14) coefficients
+static const double biquad_real[2][5] = {
+    { 0.02008, 0.04017, 0.02008, 1.56102, -0.64135 },
+    { 0.02008, 0.04017, 0.02008, 1.70410, -0.78414 },
+};
+
+static void test_biquad (void)
+{
+    enum { STAGES = 2, N = 2000 };
+    q15_t coeffs[5 * STAGES], state[4 * STAGES];
+    double st[STAGES][4] = { { 0 } };
+    double ideal[STAGES][4] = { { 0 } };
+    dsp_biquad_q15_t f;
+    double maxErr = 0;
+    int i, s, k;
+
+    for (s = 0; s != STAGES; s++)
+        for (k = 0; k != 5; k++)
+            coeffs[5 * s + k] = (q15_t) lround(biquad_real[s][k] * 16384);
+    dsp_biquad_q15_init(&f, coeffs, state, STAGES, 1);
+
+    for (i = 0; i != N; i++) {
+        q15_t x = (i < 500) ? 20000 : rnd_q15() / 2;
+        double v = x, u = x, want;
+        q15_t got;
+
+        for (s = 0; s != STAGES; s++) {
+            const q15_t *c = coeffs + 5 * s;
+            double acc = c[0] * v + c[1] * st[s][0] + c[2] * st[s][1]
+                       + c[3] * st[s][2] + c[4] * st[s][3];
+            double y = q15_out(acc, 14);
+            st[s][1] = st[s][0]; st[s][0] = v;
+            st[s][3] = st[s][2]; st[s][2] = y;
+            v = y;
+
+            // Unquantized filter with the real coefficients
+            acc = biquad_real[s][0] * u + biquad_real[s][1] * ideal[s][0]
+                + biquad_real[s][2] * ideal[s][1] + biquad_real[s][3] * ideal[s][2]
+                + biquad_real[s][4] * ideal[s][3];
+            ideal[s][1] = ideal[s][0]; ideal[s][0] = u;
+            ideal[s][3] = ideal[s][2]; ideal[s][2] = acc;
+            u = acc;
+        }
+        want = v;
+        got = dsp_biquad_q15(&f, x);
+        CHECK(got == want, "biquad q15 sample %d: %d, expected %.0f", i, got, want);
+        if (fabs(got - u) > maxErr)
+            maxErr = fabs(got - u);
+    }
+    // Coefficient rounding and truncation noise: a few LSB at DC gain 1
+    CHECK(maxErr < 48, "biquad q15 off the real filter by %.1f LSB", maxErr);
+}
+
+static void test_biquad_q31 (void)
+{
+    enum { STAGES = 2, N = 1000 };
+    q31_t coeffs[5 * STAGES], state[4 * STAGES];
+    int64_t st[STAGES][4] = { { 0 } };
+    dsp_biquad_q31_t f;
+    int i, s, k;
+
+    for (s = 0; s != STAGES; s++)
+        for (k = 0; k != 5; k++)
+            coeffs[5 * s + k] = (q31_t) llround(biquad_real[s][k] * 1073741824.0);
+    dsp_biquad_q31_init(&f, coeffs, state, STAGES, 1);
+
+    for (i = 0; i != N; i++) {
+        q31_t x = (i < 300) ? 2000000000 : (q31_t) rnd() / 2;
+        int64_t v = x;
+        q31_t got;
+
+        for (s = 0; s != STAGES; s++) {
+            const q31_t *c = coeffs + 5 * s;
+            __int128 acc = (__int128) c[0] * v + (__int128) c[1] * st[s][0]
+                         + (__int128) c[2] * st[s][1] + (__int128) c[3] * st[s][2]
+                         + (__int128) c[4] * st[s][3];
+            int64_t y = (int64_t) q31_out(acc, 30);
+            st[s][1] = st[s][0]; st[s][0] = v;
+            st[s][3] = st[s][2]; st[s][2] = y;
+            v = y;
+        }
+        got = dsp_biquad_q31(&f, x);
+        CHECK(got == v, "biquad q31 sample %d: %d, expected %lld", i, got, (long long) v);
+    }
+}
+
+static void test_rms (void)
+{
+    enum { LOG2LEN = 6, LEN = 1 << LOG2LEN, N = 3000 };
+    q15_t window[LEN];
+    double ref[LEN] = { 0 };
+    dsp_rms_q15_t r;
+    int i, k;
+
+    dsp_rms_q15_init(&r, window, LOG2LEN);
+    for (i = 0; i != N; i++) {
+        q15_t x = (i < 200) ? INT16_MIN : rnd_q15() >> (i / 500);
+        double sum = 0, want;
+        q15_t got;
+
+        ref[i & (LEN - 1)] = x;
+        for (k = 0; k != LEN; k++)
+            sum += ref[k] * ref[k];
+        want = sat(floor(sqrt(floor(sum / LEN))), 0, INT16_MAX);
+        dsp_rms_q15_update(&r, x);
+        got = dsp_rms_q15(&r);
+        CHECK(got == want, "rms sample %d: %d, expected %.0f", i, got, want);
+    }
+}
+
+/**
+    \brief Goertzel over one block, against the same recurrence in
+    double (bit exact) and against the DFT bin (within 1 %).
+    \param amp Peak amplitude of the test tone, Q15.
+*/
+static void goertzel_case (uint32_t freq, uint32_t fs, uint16_t n, int32_t amp, uint8_t shift)
+{
+    dsp_goertzel_q15_t g;
+    q15_t x[256];
+    double s1 = 0, s2 = 0, re, im, a, b, want, exact;
+    uint32_t got;
+    int i;
+
+    g.coeff = dsp_goertzel_coeff(freq, fs, n);
+    dsp_goertzel_q15_reset(&g);
+    for (i = 0; i != n; i++) {
+        x[i] = (q15_t) lround(amp * sin(2 * M_PI * freq * i / fs));
+        double s0 = x[i] + floor(g.coeff * s1 / 16384) - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    dsp_goertzel_q15_block(&g, x, n);
+    CHECK(g.s1 == s1 && g.s2 == s2, "goertzel %u Hz state %d %d, expected %.0f %.0f",
+        freq, g.s1, g.s2, s1, s2);
+
+    a = sat(floor(s1 / ldexp(1, shift)), -16383, 16383);
+    b = sat(floor(s2 / ldexp(1, shift)), -16383, 16383);
+    want = a * a + b * b - floor(g.coeff * a / 16384) * b;
+    if (want < 0) want = 0;
+    got = dsp_goertzel_q15_power(&g, shift);
+    CHECK(got == want, "goertzel %u Hz power %u, expected %.0f", freq, got, want);
+
+    // Exact DFT at the bin frequency of the coefficient
+    {
+        uint32_t k = (freq * n + fs / 2) / fs;
+        re = im = 0;
+        for (i = 0; i != n; i++) {
+            re += x[i] * cos(2 * M_PI * k * i / n);
+            im -= x[i] * sin(2 * M_PI * k * i / n);
+        }
+        exact = (re * re + im * im) / ldexp(1, 2 * shift);
+        CHECK(fabs(got - exact) <= 0.01 * exact + 4,
+            "goertzel %u Hz power %u, DFT %.0f", freq, got, exact);
+    }
+}
+
+static void test_goertzel (void)
+{
+    goertzel_case(1000, 8000, 64, 16000, 8);
+    goertzel_case(1000, 8000, 64, 32767, 8);
+    goertzel_case(1500, 8000, 256, 20000, 10);
+    goertzel_case(2000, 8000, 128, 32767, 9);
+}
+
+// Twiddle of the kernels: sin(2.pi.i/256) from the same table
+static double tw_sin (unsigned i)
+{
+    return dsp_sin_q15((uint16_t)((i & 255) << 8));
+}
+
+/**
+    \brief Complex FFT reference: recursive decimation in time, so it
+    shares no code path with the in-place kernel, rounding at the same
+    points (product >> 15, sum >> 1, saturation).
+*/
+static void cfft_ref (double *re, double *im, unsigned m)
+{
+    double er[DSP_FFT_MAX / 2], ei[DSP_FFT_MAX / 2];
+    double orr[DSP_FFT_MAX / 2], oi[DSP_FFT_MAX / 2];
+    unsigned k, h = m / 2;
+
+    if (m == 1)
+        return;
+    for (k = 0; k != h; k++) {
+        er[k] = re[2 * k];     ei[k] = im[2 * k];
+        orr[k] = re[2 * k + 1]; oi[k] = im[2 * k + 1];
+    }
+    cfft_ref(er, ei, h);
+    cfft_ref(orr, oi, h);
+    for (k = 0; k != h; k++) {
+        unsigned idx = k * (DSP_FFT_MAX / m);
+        double wr = tw_sin(idx + 64), wi = -tw_sin(idx);
+        double tr = floor((wr * orr[k] - wi * oi[k]) / 32768);
+        double ti = floor((wr * oi[k] + wi * orr[k]) / 32768);
+        re[k]     = sat(floor((er[k] + tr) / 2), INT16_MIN, INT16_MAX);
+        im[k]     = sat(floor((ei[k] + ti) / 2), INT16_MIN, INT16_MAX);
+        re[k + h] = sat(floor((er[k] - tr) / 2), INT16_MIN, INT16_MAX);
+        im[k + h] = sat(floor((ei[k] - ti) / 2), INT16_MIN, INT16_MAX);
+    }
+}
+
+// Real FFT reference, same output layout as dsp_rfft_q15
+static void rfft_ref (const double *x, double *out, unsigned n)
+{
+    double re[DSP_FFT_MAX / 2], im[DSP_FFT_MAX / 2];
+    unsigned m = n / 2, k;
+
+    for (k = 0; k != m; k++) {
+        re[k] = x[2 * k];
+        im[k] = x[2 * k + 1];
+    }
+    cfft_ref(re, im, m);
+    out[0] = floor((re[0] + im[0]) / 2);
+    out[1] = floor((re[0] - im[0]) / 2);
+    for (k = 1; k <= m / 2; k++) {
+        unsigned idx = k * (DSP_FFT_MAX / n);
+        double wr = tw_sin(idx + 64), wi = -tw_sin(idx);
+        double zr = re[k], zi = im[k], cr = re[m - k], ci = im[m - k];
+        double fer = floor((zr + cr) / 2), fei = floor((zi - ci) / 2);
+        double fo_r = floor((zi + ci) / 2), foi = floor((cr - zr) / 2);
+        double xr = floor((fer + floor((wr * fo_r - wi * foi) / 32768)) / 2);
+        double xi = floor((fei + floor((wr * foi + wi * fo_r) / 32768)) / 2);
+        double yr = floor((fer + floor((-wr * fo_r + wi * foi) / 32768)) / 2);
+        double yi = floor((-fei + floor((wr * foi + wi * fo_r) / 32768)) / 2);
+        out[2 * k]           = sat(xr, INT16_MIN, INT16_MAX);
+        out[2 * k + 1]       = sat(xi, INT16_MIN, INT16_MAX);
+        out[2 * (m - k)]     = sat(yr, INT16_MIN, INT16_MAX);
+        out[2 * (m - k) + 1] = sat(yi, INT16_MIN, INT16_MAX);
+    }
+}
+
+/**
+    \brief Real FFT: bit exact against \ref rfft_ref, and within a few
+    LSB of the DFT / n.
+*/
+static void fft_case (uint16_t n, int kind)
+{
+    q15_t buf[DSP_FFT_MAX];
+    double x[DSP_FFT_MAX], ref[DSP_FFT_MAX], maxErr = 0;
+    double bound = 2 + (31 - __builtin_clz(n));     // ~1 LSB per stage
+    int i, k, exact = 1;
+
+    for (i = 0; i != n; i++) {
+        switch (kind) {
+        case 0:  x[i] = lround(20000 * cos(2 * M_PI * 5 * i / n) + 8000 * sin(2 * M_PI * 17 * i / n)); break;
+        case 1:  x[i] = (q15_t) rnd(); break;
+        case 2:  x[i] = (i == 3) ? 32767 : 0; break;
+        case 3:  x[i] = 0x4000; break;
+        default: x[i] = (i & 1) ? INT16_MIN : INT16_MAX; break;
+        }
+        buf[i] = (q15_t) x[i];
+    }
+    dsp_rfft_q15(buf, n);
+    rfft_ref(x, ref, n);
+    for (i = 0; i != n; i++)
+        exact &= (buf[i] == ref[i]);
+    CHECK(exact, "rfft %u case %d differs from the reference", n, kind);
+
+    for (k = 0; k <= n / 2; k++) {
+        double re = 0, im = 0, gr, gi;
+        for (i = 0; i != n; i++) {
+            re += x[i] * cos(2 * M_PI * k * i / n);
+            im -= x[i] * sin(2 * M_PI * k * i / n);
+        }
+        re /= n;
+        im /= n;
+        if (k == 0)          { gr = buf[0]; gi = 0; }
+        else if (k == n / 2) { gr = buf[1]; gi = 0; }
+        else                 { gr = buf[2 * k]; gi = buf[2 * k + 1]; }
+        if (fabs(gr - re) > maxErr) maxErr = fabs(gr - re);
+        if (fabs(gi - im) > maxErr) maxErr = fabs(gi - im);
+    }
+    CHECK(maxErr <= bound, "rfft %u case %d off the DFT by %.1f LSB (bound %.0f)",
+        n, kind, maxErr, bound);
+}
+
+static void test_fft (void)
+{
+    uint16_t n;
+    int kind;
+
+    for (n = 4; n <= DSP_FFT_MAX; n <<= 1)
+        for (kind = 0; kind != 5; kind++)
+            fft_case(n, kind);
+}
+
+/**
+    \brief Detector on the A0 rate: every bin fires alone on its tone, up
+    to full scale, and the reported power follows the amplitude squared
+    (a clamped Goertzel state would flatten it).
+*/
+static void tone_case (uint8_t bin, uint32_t freq, int32_t amp, uint32_t *power)
+{
+    enum { FS = 2560 };
+    uint16_t block[TONE_BLOCK];
+    int i, b;
+
+    tone_init(FS);
+    for (b = 0; b != 3; b++) {
+        for (i = 0; i != TONE_BLOCK; i++) {
+            double t = (double)(b * TONE_BLOCK + i) / FS;
+            block[i] = (uint16_t) lround(32768 + amp * sin(2 * M_PI * freq * t));
+        }
+        tone_feed_block(block, TONE_BLOCK);
+    }
+    CHECK(tone_enabled() == 0x07, "tone enabled 0x%02x", tone_enabled());
+    CHECK(tone_detected() == (1 << bin), "tone %u Hz amplitude %d: detected 0x%02x",
+        freq, amp, tone_detected());
+    *power = tone_power(bin);
+}
+
+static void test_tone (void)
+{
+    static const uint32_t freq[TONE_BINS] = { 50, 60, 1000 };
+    uint16_t block[TONE_BLOCK];
+    uint32_t full, half;
+    uint8_t bin;
+    int i;
+
+    for (bin = 0; bin != TONE_BINS; bin++) {
+        tone_case(bin, freq[bin], 32767, &full);
+        tone_case(bin, freq[bin], 16384, &half);
+        // 2^24 at full scale; four times the half-scale power
+        CHECK(full > 15800000 && full < 17000000, "tone %u Hz full-scale power %u",
+            freq[bin], full);
+        CHECK(full / 4 > half * 0.97 && full / 4 < half * 1.03,
+            "tone %u Hz power %u at full scale, %u at half", freq[bin], full, half);
+    }
+
+    // Noise alone fires nothing
+    tone_init(2560);
+    for (i = 0; i != 3 * TONE_BLOCK; i++) {
+        block[i % TONE_BLOCK] = 32768 + (int16_t) rnd() / 4;
+        if (i % TONE_BLOCK == TONE_BLOCK - 1)
+            tone_feed_block(block, TONE_BLOCK);
+    }
+    CHECK(tone_detected() == 0, "tone noise: detected 0x%02x", tone_detected());
+}
+
+// -----------------------------------------------------------------------------
+
+static double seconds (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile int32_t sink;
+
+static void bench (void)
+{
+    enum { N = 1 << 20 };
+    static q15_t fc[32], fs[64], bc[10], bs[8], win[64], buf[256];
+    static q31_t fc31[32], fs31[64], bc31[10], bs31[8];
+    dsp_fir_q15_t fir;
+    dsp_fir_q31_t fir31;
+    dsp_biquad_q15_t bq;
+    dsp_biquad_q31_t bq31;
+    dsp_rms_q15_t rms;
+    dsp_goertzel_q15_t g;
+    double t;
+    int i;
+
+    printf("host ns/sample (regressions only; M0+ cycles are in dsp.c)\n");
+
+    dsp_fir_q15_init(&fir, fc, fs, 32);
+    t = seconds();
+    for (i = 0; i != N; i++)
+        sink = dsp_fir_q15(&fir, (q15_t) i);
+    printf("  fir q15, 32 taps      %6.1f\n", (seconds() - t) * 1e9 / N);
+
+    dsp_fir_q31_init(&fir31, fc31, fs31, 32);
+    t = seconds();
+    for (i = 0; i != N; i++)
+        sink = dsp_fir_q31(&fir31, i);
+    printf("  fir q31, 32 taps      %6.1f\n", (seconds() - t) * 1e9 / N);
+
+    dsp_biquad_q15_init(&bq, bc, bs, 2, 1);
+    t = seconds();
+    for (i = 0; i != N; i++)
+        sink = dsp_biquad_q15(&bq, (q15_t) i);
+    printf("  biquad q15, 2 stages  %6.1f\n", (seconds() - t) * 1e9 / N);
+
+    dsp_biquad_q31_init(&bq31, bc31, bs31, 2, 1);
+    t = seconds();
+    for (i = 0; i != N; i++)
+        sink = dsp_biquad_q31(&bq31, i);
+    printf("  biquad q31, 2 stages  %6.1f\n", (seconds() - t) * 1e9 / N);
+
+    dsp_rms_q15_init(&rms, win, 6);
+    t = seconds();
+    for (i = 0; i != N; i++)
+        dsp_rms_q15_update(&rms, (q15_t) i);
+    sink = dsp_rms_q15(&rms);
+    printf("  rms update            %6.1f\n", (seconds() - t) * 1e9 / N);
+
+    g.coeff = dsp_goertzel_coeff(1000, 8000, 64);
+    dsp_goertzel_q15_reset(&g);
+    t = seconds();
+    for (i = 0; i != N; i++)
+        dsp_goertzel_q15(&g, (q15_t) i);
+    sink = g.s1;
+    printf("  goertzel              %6.1f\n", (seconds() - t) * 1e9 / N);
+
+    t = seconds();
+    for (i = 0; i != N / 256; i++)
+        dsp_rfft_q15(buf, 256);
+    printf("  rfft 256              %6.1f\n", (seconds() - t) * 1e9 / N);
+}
+
+int main (int argc, char **argv)
+{
+    test_fir();
+    test_fir_q31();
+    test_biquad();
+    test_biquad_q31();
+    test_rms();
+    test_goertzel();
+    test_fft();
+    test_tone();
+    printf("dsptest: %d checks, %d failed\n", checks, failures);
+    if (!(argc > 1 && strcmp(argv[1], "-q") == 0))
+        bench();
+    return failures;
+}
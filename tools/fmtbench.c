@@ -0,0 +1,297 @@
+/**
+    \file fmtbench.c
+    \version 0.1.0
+    \date 2026-10-19
+    \brief Host check and benchmark of fmt.c. The DEBUG_MODE monitor
+    screen and the menu rows (item with value, trend row) are built as
+    main.c and app_menu.c build them, and must match snprintf with the
+    equivalent format for random and edge values. A last pass times
+    both per line, and fmt_u32 alone against its worst case.
+    \note Usage: fmtbench [-q]; -q skips the timings. Exit status is
+    the number of failed checks.
+    \note Host time only: the C library printf of the host is not the
+    newlib iprintf of the board, and the ratio is the figure to read.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "fmt.h"
+
+static int failures, checks;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        checks++;                                                           \
+        if (!(cond)) {                                                      \
+            failures++;                                                     \
+            if (failures <= 20) {                                           \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__);                 \
+                printf(__VA_ARGS__);                                        \
+                printf("\n");                                               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+// fmt_flush() target; the lines here are built with fmt_init_string()
+int console_write (const char *p, int len)
+{
+    return len;
+}
+
+// Deterministic input (xorshift32)
+static uint32_t seed = 0x1234567;
+
+static uint32_t rnd (void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+// Fields of one monitor screen, as sensor_read() gives them
+typedef struct {
+    uint16_t adc[6];
+    int16_t  accel[3];
+    int16_t  touch[2];
+    uint8_t  detected, enabled;
+} monitor_t;
+
+// A history trend row: index, then min, mean and max
+typedef struct {
+    uint32_t k;
+    int32_t  min, mean, max;
+} trend_t;
+
+static void random_monitor (monitor_t *m)
+{
+    int i;
+    for (i = 0; i != 6; i++)
+        m->adc[i] = (uint16_t) rnd();
+    for (i = 0; i != 3; i++)
+        m->accel[i] = (int16_t)(rnd() % 8192) - 4096;
+    m->touch[0] = (int16_t)(rnd() % 2000) - 1000;
+    m->touch[1] = (int16_t)(rnd() % 2000) - 1000;
+    m->detected = (uint8_t) rnd();
+    m->enabled = (uint8_t) rnd();
+}
+
+static void random_trend (trend_t *t)
+{
+    t->k = rnd() % 60 + 1;
+    t->min = (int32_t) rnd() >> (rnd() % 32);
+    t->mean = (int32_t) rnd() >> (rnd() % 32);
+    t->max = (int32_t) rnd() >> (rnd() % 32);
+}
+
+// pthMonitor() in main.c
+static uint16_t monitor_fmt (char *buf, uint16_t size, const monitor_t *m)
+{
+    static const char *const analog[6] = {
+        " A0 = ", " A1 = ", " A2 = ", " A3 = ", " A4 = ", " A5 = "
+    };
+    fmt_t f;
+    int i;
+
+    fmt_init_string (&f, buf, size);
+    fmt_str (&f, "\033[2J\033[1;1H> Request: \r\n  Analog:");
+    for (i = 0; i != 6; i++) {
+        fmt_str (&f, analog[i]);
+        fmt_u32 (&f, m->adc[i], 5, ' ');
+    }
+    fmt_str (&f, "\r\n  Inputs:  X = ");
+    fmt_i32 (&f, m->accel[0], 5, ' ');
+    fmt_str (&f, "  Y = ");
+    fmt_i32 (&f, m->accel[1], 5, ' ');
+    fmt_str (&f, "  Z = ");
+    fmt_i32 (&f, m->accel[2], 5, ' ');
+    fmt_str (&f, "\r\n  Touch:       ");
+    fmt_i32 (&f, m->touch[0], 5, ' ');
+    fmt_str (&f, "      ");
+    fmt_i32 (&f, m->touch[1], 5, ' ');
+    fmt_str (&f, "\r\n  Tones: ");
+    fmt_hex (&f, m->detected, 2);
+    fmt_str (&f, " (enabled ");
+    fmt_hex (&f, m->enabled, 2);
+    fmt_str (&f, ")\r\n");
+    return f.len;
+}
+
+static int monitor_printf (char *buf, size_t size, const monitor_t *m)
+{
+    return snprintf(buf, size, "\033[2J\033[1;1H> Request: \r\n  Analog:"
+        " A0 = %5u A1 = %5u A2 = %5u A3 = %5u A4 = %5u A5 = %5u"
+        "\r\n  Inputs:  X = %5d  Y = %5d  Z = %5d"
+        "\r\n  Touch:       %5d      %5d"
+        "\r\n  Tones: 0x%02x (enabled 0x%02x)\r\n",
+        m->adc[0], m->adc[1], m->adc[2], m->adc[3], m->adc[4], m->adc[5],
+        m->accel[0], m->accel[1], m->accel[2], m->touch[0], m->touch[1],
+        m->detected, m->enabled);
+}
+
+// aRows() in app_menu.c, the selected item with its value
+static uint16_t item_fmt (char *buf, uint16_t size, const char *name, int32_t value)
+{
+    fmt_t f;
+
+    fmt_init_string (&f, buf, size);
+    fmt_str (&f, "> ");
+    fmt_str (&f, name);
+    fmt_str (&f, ": ");
+    fmt_i32 (&f, value, 0, ' ');
+    return f.len;
+}
+
+static int item_printf (char *buf, size_t size, const char *name, int32_t value)
+{
+    return snprintf(buf, size, "> %s: %ld", name, (long) value);
+}
+
+// aHistoryRows() in app_menu.c
+static uint16_t trend_fmt (char *buf, uint16_t size, const trend_t *t)
+{
+    fmt_t f;
+
+    fmt_init_string (&f, buf, size);
+    fmt_u32 (&f, t->k, 5, ' ');
+    fmt_i32 (&f, t->min, 10, ' ');
+    fmt_i32 (&f, t->mean, 10, ' ');
+    fmt_i32 (&f, t->max, 10, ' ');
+    return f.len;
+}
+
+static int trend_printf (char *buf, size_t size, const trend_t *t)
+{
+    return snprintf(buf, size, "%5lu%10ld%10ld%10ld", (unsigned long) t->k,
+        (long) t->min, (long) t->mean, (long) t->max);
+}
+
+static void test_lines (void)
+{
+    static const int32_t edge[] = {
+        0, 1, -1, 9, -9, 10, -10, 99999, -99999, 100000, 999999999,
+        1000000000, INT32_MAX, INT32_MIN, INT32_MIN + 1
+    };
+    char a[256], b[256];
+    monitor_t m;
+    trend_t t;
+    uint16_t n;
+    unsigned i;
+
+    for (i = 0; i != 20000; i++) {
+        random_monitor(&m);
+        n = monitor_fmt(a, sizeof(a), &m);
+        monitor_printf(b, sizeof(b), &m);
+        CHECK(n == strlen(b) && memcmp(a, b, n) == 0, "monitor line %u", i);
+
+        random_trend(&t);
+        n = trend_fmt(a, sizeof(a), &t);
+        trend_printf(b, sizeof(b), &t);
+        CHECK(n == strlen(b) && memcmp(a, b, n) == 0, "trend %.*s / %s", n, a, b);
+    }
+    for (i = 0; i != sizeof(edge) / sizeof(edge[0]); i++) {
+        n = item_fmt(a, sizeof(a), "AccX", edge[i]);
+        item_printf(b, sizeof(b), "AccX", edge[i]);
+        CHECK(n == strlen(b) && memcmp(a, b, n) == 0, "item %.*s / %s", n, a, b);
+
+        t.k = i;
+        t.min = t.mean = t.max = edge[i];
+        n = trend_fmt(a, sizeof(a), &t);
+        trend_printf(b, sizeof(b), &t);
+        CHECK(n == strlen(b) && memcmp(a, b, n) == 0, "trend %.*s / %s", n, a, b);
+    }
+
+    // A full string buffer truncates, a console one would flush
+    n = item_fmt(a, 8, "AccX", -123456);
+    CHECK(n == 8 && memcmp(a, "> AccX: ", 8) == 0, "truncated to %u", n);
+}
+
+static double seconds (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile uint32_t sink;
+
+static void bench (void)
+{
+    enum { N = 1 << 18, SETS = 64 };
+    static monitor_t m[SETS];
+    static trend_t t[SETS];
+    char buf[256];
+    double s, tf, tp;
+    fmt_t f;
+    int i;
+
+    for (i = 0; i != SETS; i++) {
+        random_monitor(&m[i]);
+        random_trend(&t[i]);
+    }
+
+    printf("host ns per line        fmt  snprintf  ratio\n");
+
+    s = seconds();
+    for (i = 0; i != N; i++)
+        sink = monitor_fmt(buf, sizeof(buf), &m[i & (SETS - 1)]);
+    tf = (seconds() - s) * 1e9 / N;
+    s = seconds();
+    for (i = 0; i != N; i++)
+        sink = monitor_printf(buf, sizeof(buf), &m[i & (SETS - 1)]);
+    tp = (seconds() - s) * 1e9 / N;
+    printf("  monitor screen     %6.1f    %6.1f  %5.1f\n", tf, tp, tp / tf);
+
+    s = seconds();
+    for (i = 0; i != N; i++)
+        sink = item_fmt(buf, sizeof(buf), "AccX", t[i & (SETS - 1)].mean);
+    tf = (seconds() - s) * 1e9 / N;
+    s = seconds();
+    for (i = 0; i != N; i++)
+        sink = item_printf(buf, sizeof(buf), "AccX", t[i & (SETS - 1)].mean);
+    tp = (seconds() - s) * 1e9 / N;
+    printf("  menu item          %6.1f    %6.1f  %5.1f\n", tf, tp, tp / tf);
+
+    s = seconds();
+    for (i = 0; i != N; i++)
+        sink = trend_fmt(buf, sizeof(buf), &t[i & (SETS - 1)]);
+    tf = (seconds() - s) * 1e9 / N;
+    s = seconds();
+    for (i = 0; i != N; i++)
+        sink = trend_printf(buf, sizeof(buf), &t[i & (SETS - 1)]);
+    tp = (seconds() - s) * 1e9 / N;
+    printf("  trend row          %6.1f    %6.1f  %5.1f\n", tf, tp, tp / tf);
+
+    // 3999999999 has the largest digit sum of any uint32_t: 84
+    // subtractions, against 0 for the digits of 1000000000
+    printf("host ns per fmt_u32\n");
+    s = seconds();
+    for (i = 0; i != N; i++) {
+        fmt_init_string(&f, buf, sizeof(buf));
+        fmt_u32(&f, 1000000000u + (i & 1), 0, ' ');
+        sink = f.len;
+    }
+    printf("  1000000000         %6.1f\n", (seconds() - s) * 1e9 / N);
+    s = seconds();
+    for (i = 0; i != N; i++) {
+        fmt_init_string(&f, buf, sizeof(buf));
+        fmt_u32(&f, 3999999999u - (i & 1), 0, ' ');
+        sink = f.len;
+    }
+    printf("  3999999999         %6.1f\n", (seconds() - s) * 1e9 / N);
+}
+
+int main (int argc, char **argv)
+{
+    test_lines();
+    printf("fmtbench: %d checks, %d failed\n", checks, failures);
+    if (!(argc > 1 && strcmp(argv[1], "-q") == 0))
+        bench();
+    return failures;
+}
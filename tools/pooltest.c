@@ -0,0 +1,320 @@
+/**
+    \file pooltest.c
+    \version 0.1.0
+    \date 2026-10-19
+    \brief Host stress test of the block pools. pool.c is built in, on a
+    static heap, and driven by random allocations and frees of 1 to 600
+    bytes against a shadow model. After every operation the model and
+    pool_stats() must agree on used, highWater and fails, and every free
+    list must hold exactly the blocks not in use. The block a request
+    gets is the smallest class that fits, or the next larger one when
+    that class is empty (spill-over). Every live block carries a
+    pattern that must survive until its free. A last pass times
+    allocate and free.
+    \note Usage: pooltest [-q]; -q skips the timings. Exit status is the
+    number of failed checks.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#define HOST_MODEL                      // common.h: no PRIMASK, no asm
+#define RAMFUNC_IN_FLASH                // No .ramfunc section on the host
+#define iprintf printf
+#define interrupt(kind) used            // ARM handler attribute
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <setjmp.h>
+#include <time.h>
+
+#include "../pool.c"
+
+static int failures, checks;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        checks++;                                                           \
+        if (!(cond)) {                                                      \
+            failures++;                                                     \
+            if (failures <= 20) {                                           \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__);                 \
+                printf(__VA_ARGS__);                                        \
+                printf("\n");                                               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+// The heap of memory.c, in .bss like the firmware's
+static char heap[4096] __attribute__ ((aligned(8)));
+static int heapUsed;
+
+char *_sbrk (int len)
+{
+    char *p = heap + heapUsed;
+
+    if (heapUsed + len > (int) sizeof(heap))
+        return (char *) -1;
+    heapUsed += len;
+    return p;
+}
+
+// pool_free() of a foreign pointer must stop here
+static jmp_buf faulted;
+static uint32_t faultPattern;
+
+void fault (uint32_t pattern)
+{
+    faultPattern = pattern;
+    longjmp(faulted, 1);
+}
+
+// Deterministic input (xorshift32)
+static uint32_t seed = 0x1234567;
+
+static uint32_t rnd (void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+#define LIVE_MAX    (POOL_SMALL_LEN + POOL_PACKET_LEN + POOL_BLOCK_LEN)
+
+static struct {
+    uint8_t  *p;
+    uint16_t size;
+    uint8_t  cls;
+    uint8_t  mark;
+} live[LIVE_MAX];
+static int nlive;
+
+// Shadow of the counters
+static pool_stat_t model[POOL_CLASSES];
+static uint32_t spills, refused, tooLarge;
+static uint64_t requested, granted;
+
+static int class_of (const void *p)
+{
+    int cls;
+
+    for (cls = 0; cls != POOL_CLASSES; cls++) {
+        if ((const uint8_t *) p >= pools[cls].start && (const uint8_t *) p < pools[cls].end)
+            return cls;
+    }
+    return -1;
+}
+
+// Every free list: blocks of its class, on block boundaries, no block
+// twice, none in use, and as many as the class has left
+static void check_lists (void)
+{
+    uint8_t seen[POOL_BLOCK_LEN > POOL_SMALL_LEN ? POOL_BLOCK_LEN : POOL_SMALL_LEN];
+    int cls, i, n;
+    block_t *b;
+
+    for (cls = 0; cls != POOL_CLASSES; cls++) {
+        pool_class_t *c = &pools[cls];
+
+        memset(seen, 0, sizeof(seen));
+        n = 0;
+        for (b = c->free; b != NULL && n <= c->stat.len; b = b->next) {
+            uint32_t offset = (uint8_t *) b - c->start;
+            uint32_t k = offset / c->stat.size;
+
+            if ((uint8_t *) b < c->start || (uint8_t *) b >= c->end ||
+                offset % c->stat.size != 0) {
+                CHECK(0, "class %d: free list points off its blocks", cls);
+                return;
+            }
+            CHECK(!seen[k], "class %d: block %u twice on the free list", cls, (unsigned) k);
+            seen[k] = 1;
+            for (i = 0; i != nlive; i++)
+                CHECK(live[i].p != (uint8_t *) b, "class %d: block %u free and in use", cls, (unsigned) k);
+            n++;
+        }
+        CHECK(n == c->stat.len - model[cls].used, "class %d: %d free blocks, %d expected",
+            cls, n, c->stat.len - model[cls].used);
+    }
+}
+
+static void check_stats (void)
+{
+    pool_stat_t s;
+    int cls;
+
+    for (cls = 0; cls != POOL_CLASSES; cls++) {
+        pool_stats(cls, &s);
+        CHECK(s.used == model[cls].used && s.highWater == model[cls].highWater &&
+              s.fails == model[cls].fails,
+            "class %d: used %u peak %u fails %u, model %u %u %u", cls,
+            s.used, s.highWater, s.fails,
+            model[cls].used, model[cls].highWater, model[cls].fails);
+    }
+}
+
+static void do_alloc (uint16_t size)
+{
+    int cls, first = -1, want = -1;
+    uint8_t *p;
+
+    for (cls = 0; cls != POOL_CLASSES; cls++) {
+        if (size > pools[cls].stat.size)
+            continue;
+        if (first < 0)
+            first = cls;
+        if (want < 0 && model[cls].used < pools[cls].stat.len)
+            want = cls;
+    }
+
+    p = pool_alloc(size);
+    if (want < 0) {
+        CHECK(p == NULL, "%u bytes: got a block with every fitting class full", size);
+        if (first >= 0) {
+            model[first].fails++;
+            refused++;
+        }
+        else
+            tooLarge++;
+        return;
+    }
+    CHECK(p != NULL, "%u bytes: refused, class %d has room", size, want);
+    if (p == NULL)
+        return;
+    cls = class_of(p);
+    CHECK(cls == want, "%u bytes: class %d, expected %d", size, cls, want);
+    CHECK(((uintptr_t) p & 3) == 0, "%u bytes: block not word aligned", size);
+    if (cls != first)
+        spills++;
+    if (++model[want].used > model[want].highWater)
+        model[want].highWater = model[want].used;
+    requested += size;
+    granted += pools[want].stat.size;
+
+    live[nlive].p = p;
+    live[nlive].size = size;
+    live[nlive].cls = want;
+    live[nlive].mark = (uint8_t) rnd();
+    memset(p, live[nlive].mark, size);
+    nlive++;
+}
+
+static void do_free (int i)
+{
+    uint16_t k;
+
+    for (k = 0; k != live[i].size; k++) {
+        if (live[i].p[k] != live[i].mark) {
+            CHECK(0, "block of %u bytes overwritten at %u", live[i].size, k);
+            break;
+        }
+    }
+    pool_free(live[i].p);
+    model[live[i].cls].used--;
+    live[i] = live[--nlive];
+}
+
+static void test_stress (void)
+{
+    uint32_t op;
+    int cls;
+
+    for (op = 0; op != 200000; op++) {
+        if (nlive != 0 && (rnd() % 100 < 45 || nlive == LIVE_MAX))
+            do_free(rnd() % nlive);
+        else if (rnd() % 100 < 60)
+            do_alloc(rnd() % POOL_PACKET_SIZE + 1);         // Small and packet sizes
+        else
+            do_alloc(rnd() % 600 + 1);                      // Up to past the largest class
+        check_stats();
+        check_lists();
+    }
+    while (nlive)
+        do_free(0);
+    check_stats();
+    check_lists();
+
+    CHECK(spills != 0, "no request spilled into a larger class");
+    CHECK(refused != 0, "no request refused");
+    CHECK(tooLarge != 0, "no request above the largest class");
+    for (cls = 0; cls != POOL_CLASSES; cls++)
+        CHECK(model[cls].highWater == pools[cls].stat.len, "class %d never full", cls);
+}
+
+static void test_edges (void)
+{
+    uint8_t other[16];
+    void *p;
+
+    pool_free(NULL);                                    // Ignored
+    check_stats();
+
+    faultPattern = 0;
+    if (setjmp(faulted) == 0) {
+        pool_free(other);
+        CHECK(0, "a foreign pointer was taken back");
+    }
+    CHECK(faultPattern == 0b10101100, "fault 0x%02x", (unsigned) faultPattern);
+
+    p = pool_alloc(POOL_BLOCK_SIZE + 1);
+    CHECK(p == NULL, "%u bytes granted", POOL_BLOCK_SIZE + 1);
+    check_stats();                                      // Counted nowhere
+}
+
+static double seconds (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void * volatile sink;
+
+static void bench (void)
+{
+    enum { N = 1 << 22 };
+    static const uint16_t sizes[3] = { POOL_SMALL_SIZE, POOL_PACKET_SIZE, POOL_BLOCK_SIZE };
+    void *held[POOL_SMALL_LEN];
+    double t;
+    int i, k;
+
+    printf("host ns per operation\n");
+    for (k = 0; k != 3; k++) {
+        t = seconds();
+        for (i = 0; i != N; i++) {
+            sink = pool_alloc(sizes[k]);
+            pool_free(sink);
+        }
+        printf("  alloc + free, %3u bytes  %6.1f\n", sizes[k], (seconds() - t) * 1e9 / N);
+    }
+
+    // Small class full: every request walks on to the packet class
+    for (i = 0; i != POOL_SMALL_LEN; i++)
+        held[i] = pool_alloc(POOL_SMALL_SIZE);
+    t = seconds();
+    for (i = 0; i != N; i++) {
+        sink = pool_alloc(POOL_SMALL_SIZE);
+        pool_free(sink);
+    }
+    printf("  alloc + free, spilled    %6.1f\n", (seconds() - t) * 1e9 / N);
+    for (i = 0; i != POOL_SMALL_LEN; i++)
+        pool_free(held[i]);
+
+    printf("fragmentation: %.1f%% of the granted bytes unused (requests 1 to 600)\n",
+        100.0 * (granted - requested) / granted);
+}
+
+int main (int argc, char **argv)
+{
+    pool_init();
+    test_edges();
+    test_stress();
+    printf("pooltest: %d checks, %d failed (%u spilled, %u refused)\n", checks, failures,
+        (unsigned) spills, (unsigned) refused);
+    if (!(argc > 1 && strcmp(argv[1], "-q") == 0))
+        bench();
+    return failures;
+}
@@ -0,0 +1,162 @@
+/**
+    \file touchbench.c
+    \version 0.1.0
+    \date 2026-10-19
+    \brief Host check and benchmark of the TSI scan sequence. touch.c is
+    built in with its TSI, SIM, PORT and NVIC registers as plain structs,
+    so touch_init() builds next_channel[] as on the board. For every
+    channel mask the table must give the channel that the search loop
+    of the old TSI0_IRQHandler found, and a full scan must end on the
+    same channel. A last pass times both lookups per interrupt.
+    \note Usage: touchbench [-q]; -q skips the timings. Exit status is
+    the number of failed checks.
+    \note Host time only, at host clock: the ratio between the two is
+    what carries over to the M0+.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#define HOST_MODEL                      // common.h: no PRIMASK, no asm
+#define RAMFUNC_IN_FLASH                // No .ramfunc section on the host
+#define iprintf printf
+#define interrupt(kind) used            // ARM handler attribute
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "OpenKL25Z.h"
+
+static struct TSI_MemMap tsi_regs;
+static struct SIM_MemMap sim_regs;
+static struct PORT_MemMap portb_regs;
+static struct NVIC_MemMap nvic_regs;
+
+#undef TSI0_BASE_PTR
+#undef SIM_BASE_PTR
+#undef PORTB_BASE_PTR
+#undef NVIC_BASE_PTR
+#define TSI0_BASE_PTR   ((TSI_MemMapPtr) &tsi_regs)
+#define SIM_BASE_PTR    ((SIM_MemMapPtr) &sim_regs)
+#define PORTB_BASE_PTR  ((PORT_MemMapPtr) &portb_regs)
+#define NVIC_BASE_PTR   ((NVIC_MemMapPtr) &nvic_regs)
+
+#include "../touch.c"
+
+volatile uint32_t sysTicks;
+
+static int failures, checks;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        checks++;                                                           \
+        if (!(cond)) {                                                      \
+            failures++;                                                     \
+            if (failures <= 20) {                                           \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__);                 \
+                printf(__VA_ARGS__);                                        \
+                printf("\n");                                               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+// Next channel as TSI0_IRQHandler searched it before the table
+static uint32_t search_next (uint32_t channel)
+{
+    for(;;) {
+        channel = (channel + 1) % NCHANNELS;
+        if ((1 << channel) & enable_mask)
+            return channel;
+    }
+}
+
+// A plain struct keeps what is written: EOSF set makes every scan of
+// touch_init() complete at once
+static void init (uint32_t mask)
+{
+    memset(&tsi_regs, 0, sizeof(tsi_regs));
+    tsi_regs.GENCS = TSI_GENCS_EOSF_MASK;
+    touch_init(mask);
+}
+
+static void test_sequence (void)
+{
+    uint32_t mask, c, next;
+
+    for (mask = 1; mask <= 0xFFFF; mask++) {
+        init(mask);
+        for (c = 0; c != NCHANNELS; c++) {
+            if (!(mask & (1 << c)))
+                continue;
+            next = search_next(c);
+            CHECK(next_channel[c] == next, "mask 0x%04x: after %u, %u instead of %u",
+                (unsigned) mask, (unsigned) c, next_channel[c], (unsigned) next);
+            // The old handler ended a scan on wrapping around
+            CHECK((c == last_channel) == (next <= c), "mask 0x%04x: scan end at %u",
+                (unsigned) mask, (unsigned) c);
+        }
+    }
+}
+
+static double seconds (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile uint32_t sink;
+
+static void bench (void)
+{
+    enum { N = 1 << 22 };
+    static const struct {
+        uint32_t mask;
+        const char *name;
+    } masks[] = {
+        { (1 << TOUCH_CH_LOW) | (1 << TOUCH_CH_HIGH), "board (9, 10)" },
+        { 1 << 5,                       "one channel" },
+        { (1 << 0) | (1 << 15),         "0 and 15" },
+        { 0x5555,                       "every other" },
+        { 0xFFFF,                       "all 16" },
+    };
+    double t, search, table;
+    uint32_t c;
+    unsigned m;
+    int i;
+
+    printf("host ns per interrupt, next channel lookup\n");
+    printf("  mask             search  table  ratio\n");
+    for (m = 0; m != sizeof(masks) / sizeof(masks[0]); m++) {
+        init(masks[m].mask);
+
+        c = last_channel;
+        t = seconds();
+        for (i = 0; i != N; i++) {
+            c = search_next(c);
+            sink = c;
+        }
+        search = (seconds() - t) * 1e9 / N;
+
+        c = last_channel;
+        t = seconds();
+        for (i = 0; i != N; i++) {
+            c = next_channel[c];
+            sink = c;
+        }
+        table = (seconds() - t) * 1e9 / N;
+
+        printf("  %-15s %7.2f %6.2f %6.1f\n", masks[m].name, search, table, search / table);
+    }
+}
+
+int main (int argc, char **argv)
+{
+    test_sequence();
+    printf("touchbench: %d checks, %d failed\n", checks, failures);
+    if (!(argc > 1 && strcmp(argv[1], "-q") == 0))
+        bench();
+    return failures;
+}
@@ -0,0 +1,935 @@
+/**
+    \file usbmodel.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Host model of the KL25Z USB-FS controller in device mode, with
+    a scripted host, to run usb.c off target. The model keeps what
+    usb.c depends on: buffer descriptor ownership (OWN, DATA01, token
+    PID written back), the even/odd bank per endpoint and direction
+    (ODDRST), the four-entry STAT FIFO behind TOKDNE, TXSUSPENDTOKENBUSY
+    after SETUP, EPSTALL and the SLEEP/RESUME flags. USBOTG_IRQHandler()
+    runs after each transaction. The host enumerates the device, checks
+    every descriptor, then runs CDC and stream bulk traffic: data
+    toggles, ZLPs, the held OUT banks of the flow control, endpoint
+    halt and status requests, block hand-back. A last pass simulates bus time per transfer size.
+    \note Usage: usbmodel [-q]; -q skips the throughput tables. Exit
+    status is the number of failed checks.
+    \note Bus time follows the full-speed bulk budget of USB 2.0 section
+    5.8.4: 13 byte times of protocol per transaction, so at most 19
+    packets of 64 bytes in a 1 ms frame. Bit stuffing and interrupt
+    latency are left out: the handler runs between two transactions.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "usbmodel.h"
+#include "common.h"
+#include "usb.h"
+#include "pool.h"
+#include "trace.h"
+
+void USBOTG_IRQHandler (void);
+
+static int failures, checks;
+
+#define CHECK(cond, ...)                                                    \
+    do {                                                                    \
+        checks++;                                                           \
+        if (!(cond)) {                                                      \
+            failures++;                                                     \
+            if (failures <= 20) {                                           \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__);                 \
+                printf(__VA_ARGS__);                                        \
+                printf("\n");                                               \
+            }                                                               \
+        }                                                                   \
+    } while (0)
+
+// Deterministic payload (xorshift32)
+static uint32_t seed = 0x1234567;
+
+static uint8_t rnd (void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (uint8_t) seed;
+}
+
+// -----------------------------------------------------------------------------
+// Controller (SIE) model
+
+struct USB_MemMap usb_model_regs;
+struct SIM_MemMap usb_model_sim;
+struct NVIC_MemMap usb_model_nvic;
+
+static struct USB_MemMap *const usb = &usb_model_regs;
+
+// Trace records are dropped: the formats live in a linker section
+const char __trace_fmt_start[1];
+
+void trace_put (uint16_t fmt, uint32_t a, uint32_t b)
+{
+}
+
+// Heap for pool.c, which holds the CDC packet buffers: a static area
+// keeps them in .bss like the firmware's, within 32 bits of address
+static char heap[2048] __attribute__ ((aligned(8)));
+static int heapUsed;
+
+char *_sbrk (int len)
+{
+    char *p = heap + heapUsed;
+
+    if (heapUsed + len > (int) sizeof(heap))
+        return (char *) -1;
+    heapUsed += len;
+    return p;
+}
+
+void fault (uint32_t pattern)
+{
+    printf("fault 0x%02x\n", (unsigned) pattern);
+    exit(100);
+}
+
+// Buffer descriptor as usb.c lays it out
+typedef struct {
+    uint8_t stat;
+    uint8_t _dummy;
+    uint16_t count;
+    uint8_t *addr;
+} bd_t;
+extern bd_t bdt[];
+
+#define BD_OWN          0x80
+#define BD_DATA01       0x40
+#define BD_STALL        0x04
+#define BD_PID_SHIFT    2
+
+#define PID_OUT         0x01
+#define PID_IN          0x09
+#define PID_SETUP       0x0D
+
+enum { ACK, NAK, STALL, TIMEOUT };
+
+static struct {
+    uint8_t fifo[4];                // STAT FIFO, fifo[0] is in USB0_STAT
+    uint8_t nfifo;
+    uint8_t odd[16][2];             // Next bank, per endpoint and direction
+} sie;
+
+// USBRESET resets the module and reads back 0 at once
+volatile uint8_t *usb_model_usbtrc0 (void)
+{
+    if (usb->USBTRC0 & USB_USBTRC0_USBRESET_MASK) {
+        memset(usb, 0, sizeof(*usb));
+        memset(&sie, 0, sizeof(sie));
+    }
+    return &usb->USBTRC0;
+}
+
+// Write-one-to-clear; clearing TOKDNE moves the STAT FIFO on
+void usb_model_istat_clear (uint8_t mask)
+{
+    usb->ISTAT &= ~mask;
+    if ((mask & USB_ISTAT_TOKDNE_MASK) && sie.nfifo) {
+        memmove(sie.fifo, sie.fifo + 1, --sie.nfifo);
+        if (sie.nfifo) {
+            usb->STAT = sie.fifo[0];
+            usb->ISTAT |= USB_ISTAT_TOKDNE_MASK;
+        }
+    }
+}
+
+// Take the USB interrupt while an enabled flag is pending
+static void irq (void)
+{
+    int n = 0;
+
+    if (!(usb_model_nvic.ISER & (1u << (INT_USB0 - 16))))
+        return;
+    while (usb->ISTAT & usb->INTEN) {
+        if (++n > 4) {
+            CHECK(0, "interrupt flags 0x%02x never cleared", usb->ISTAT & usb->INTEN);
+            return;
+        }
+        USBOTG_IRQHandler();
+    }
+}
+
+static void sie_stall (void)
+{
+    usb->ISTAT |= USB_ISTAT_STALL_MASK;
+    irq();
+}
+
+// One token to addr/ep as the SIE handles it. IN returns the packet in
+// data, its length in *len and its PID in *data01; OUT and SETUP
+// deliver *len bytes sent as DATA *data01
+static int sie_token (int addr, int pid, int ep, uint8_t *data, int *len, int *data01)
+{
+    int tx = (pid == PID_IN), bank;
+    uint8_t endpt = usb->ENDPOINT[ep].ENDPT, stat;
+    bd_t *bd;
+
+    if (!(usb->CONTROL & USB_CONTROL_DPPULLUPNONOTG_MASK)
+            || !(usb->CTL & USB_CTL_USBENSOFEN_MASK))
+        return TIMEOUT;                             // Detached or disabled
+    if ((usb->ADDR & 0x7F) != addr)
+        return TIMEOUT;                             // Not our address
+    if (!(endpt & (tx ? USB_ENDPT_EPTXEN_MASK : USB_ENDPT_EPRXEN_MASK)))
+        return TIMEOUT;
+    if ((usb->CTL & USB_CTL_TXSUSPENDTOKENBUSY_MASK) || sie.nfifo == 4)
+        return NAK;
+    if (pid != PID_SETUP && (endpt & USB_ENDPT_EPSTALL_MASK)) {
+        sie_stall();
+        return STALL;
+    }
+
+    // While ODDRST is set every endpoint stays on its even bank
+    if (usb->CTL & USB_CTL_ODDRST_MASK)
+        memset(sie.odd, 0, sizeof(sie.odd));
+    bank = sie.odd[ep][tx];
+    bd = &bdt[ep * 4 + tx * 2 + bank];
+    if (!(bd->stat & BD_OWN))
+        return NAK;
+    if (bd->stat & BD_STALL) {
+        sie_stall();
+        return STALL;
+    }
+
+    if (tx) {
+        *len = bd->count;
+        if (*len)
+            memcpy(data, bd->addr, *len);
+        *data01 = !!(bd->stat & BD_DATA01);
+    } else {
+        if (*len > bd->count) {
+            CHECK(0, "ep %d: %d byte packet into a %d byte buffer", ep, *len, bd->count);
+            return TIMEOUT;
+        }
+        if (*len)
+            memcpy(bd->addr, data, *len);
+        bd->count = *len;
+    }
+    bd->stat = (*data01 ? BD_DATA01 : 0) | (pid << BD_PID_SHIFT);  // CPU owns it
+    if (!(usb->CTL & USB_CTL_ODDRST_MASK))
+        sie.odd[ep][tx] ^= 1;
+
+    stat = (ep << 4) | (tx ? USB_STAT_TX_MASK : 0) | (bank ? USB_STAT_ODD_MASK : 0);
+    sie.fifo[sie.nfifo++] = stat;
+    if (sie.nfifo == 1)
+        usb->STAT = stat;
+    usb->ISTAT |= USB_ISTAT_TOKDNE_MASK;
+    if (pid == PID_SETUP)
+        usb->CTL |= USB_CTL_TXSUSPENDTOKENBUSY_MASK;
+    irq();
+    return ACK;
+}
+
+// -----------------------------------------------------------------------------
+// Host
+
+#define FRAME_BYTES     1500        // 12 Mbit/s for 1 ms
+#define SOF_BYTES       6
+#define XACT_BYTES      13          // Token, data framing, handshake, gaps
+#define NODATA_BYTES    9           // Token and a NAK or STALL
+#define RETRIES         32          // NAKed control transactions, frames
+
+static struct {
+    uint8_t addr;
+    uint8_t toggle[16][2];          // Next DATA0/1, per endpoint and direction
+    uint16_t maxp[16][2];           // wMaxPacketSize
+    uint32_t frame;
+    int left;                       // Byte times left in the frame
+    uint32_t packets, zlps, naks;
+} host;
+
+// The device main loop: runs between two transactions
+static void (*app)(void);
+
+static void next_frame (void)
+{
+    host.frame++;
+    host.left = FRAME_BYTES - SOF_BYTES;
+}
+
+// One transaction, scheduled for a packet of up to maxp bytes
+static int xact (int pid, int ep, uint8_t *data, int *len, int maxp)
+{
+    int tx = (pid == PID_IN), d01 = host.toggle[ep][tx], r;
+
+    if (host.left < maxp + XACT_BYTES)
+        next_frame();
+    r = sie_token(host.addr, pid, ep, data, len, &d01);
+    if (r == ACK) {
+        if (tx)
+            CHECK(d01 == host.toggle[ep][1], "ep %d IN: DATA%d, expected DATA%d",
+                ep, d01, host.toggle[ep][1]);
+        host.toggle[ep][tx] ^= 1;
+        host.packets++;
+        if (*len == 0)
+            host.zlps++;
+        host.left -= *len + XACT_BYTES;
+    } else {
+        if (r == NAK)
+            host.naks++;
+        host.left -= tx ? NODATA_BYTES : *len + XACT_BYTES;
+    }
+    if (app)
+        app();
+    return r;
+}
+
+static int xact_retry (int pid, int ep, uint8_t *data, int *len, int maxp)
+{
+    int r, tries = 0, out = *len;
+
+    while ((r = xact(pid, ep, data, len, maxp)) == NAK && ++tries < RETRIES) {
+        next_frame();
+        *len = out;
+    }
+    return r;
+}
+
+static void bus_reset (void)
+{
+    sie.nfifo = 0;
+    memset(host.toggle, 0, sizeof(host.toggle));
+    host.addr = 0;
+    usb->ISTAT |= USB_ISTAT_USBRST_MASK;
+    irq();
+}
+
+// SETUP stage: DATA0, then the data and status stages start at DATA1
+static int setup (uint8_t type, uint8_t request, uint16_t value,
+    uint16_t index, uint16_t length)
+{
+    uint8_t pkt[8] = { type, request, value, value >> 8,
+                       index, index >> 8, length, length >> 8 };
+    int len = 8;
+
+    host.toggle[0][0] = 0;
+    if (xact_retry(PID_SETUP, 0, pkt, &len, 8) != ACK)
+        return -1;
+    host.toggle[0][0] = host.toggle[0][1] = 1;
+    return 0;
+}
+
+// Control transfer on endpoint 0: SETUP, data stage, status stage.
+// Returns the data stage length, -1 on STALL or no answer
+static int control (uint8_t type, uint8_t request, uint16_t value,
+    uint16_t index, uint16_t length, uint8_t *data)
+{
+    static uint8_t pkt[1024];
+    int maxp = host.maxp[0][1], n = 0, len = 0, r;
+
+    if (setup(type, request, value, index, length) < 0)
+        return -1;
+
+    if (type & 0x80) {
+        while (n < length) {
+            if (xact_retry(PID_IN, 0, pkt, &len, maxp) != ACK)
+                return -1;
+            CHECK(len <= length - n, "request 0x%02x: %d bytes past wLength", request,
+                len - (length - n));
+            if (len > length - n)
+                len = length - n;
+            memcpy(data + n, pkt, len);
+            n += len;
+            if (len < maxp)
+                break;
+        }
+        host.toggle[0][0] = 1;
+        len = 0;
+        r = xact_retry(PID_OUT, 0, pkt, &len, 0);
+    } else {
+        while (n < length) {
+            len = (length - n < maxp) ? length - n : maxp;
+            if (xact_retry(PID_OUT, 0, data + n, &len, maxp) != ACK)
+                return -1;
+            n += len;
+        }
+        host.toggle[0][1] = 1;
+        r = xact_retry(PID_IN, 0, pkt, &len, maxp);
+        if (r == ACK)
+            CHECK(len == 0, "request 0x%02x: status stage of %d bytes", request, len);
+    }
+    return (r == ACK) ? n : -1;
+}
+
+// Bulk IN transfer: packets until a short one or size bytes. A NAK moves
+// to the next frame; after 'frames' of them the partial transfer is
+// returned. -1 on STALL or no answer
+static int bulk_in (int ep, uint8_t *buf, int size, int frames)
+{
+    static uint8_t pkt[1024];
+    int maxp = host.maxp[ep][1], n = 0, len, r, naks = 0;
+
+    while (n < size) {
+        r = xact(PID_IN, ep, pkt, &len, maxp);
+        if (r == NAK) {
+            if (++naks >= frames)
+                break;
+            next_frame();
+            continue;
+        }
+        if (r != ACK)
+            return -1;
+        CHECK(len <= maxp, "ep %d: %d byte packet, wMaxPacketSize %d", ep, len, maxp);
+        CHECK(len <= size - n, "ep %d: %d bytes past the transfer", ep, len - (size - n));
+        if (len > size - n)
+            len = size - n;
+        memcpy(buf + n, pkt, len);
+        n += len;
+        if (len < maxp)
+            break;                  // Short packet or ZLP: transfer complete
+    }
+    return n;
+}
+
+static int bulk_out (int ep, const uint8_t *buf, int size, int frames)
+{
+    int maxp = host.maxp[ep][0], n = 0, len, r, naks = 0;
+
+    while (n < size) {
+        len = (size - n < maxp) ? size - n : maxp;
+        r = xact(PID_OUT, ep, (uint8_t *) buf + n, &len, maxp);
+        if (r == NAK) {
+            if (++naks >= frames)
+                break;
+            next_frame();
+            continue;
+        }
+        if (r != ACK)
+            return -1;
+        n += len;
+    }
+    return n;
+}
+
+// -----------------------------------------------------------------------------
+// Enumeration and descriptors
+
+#define ADDRESS     7
+
+static uint8_t desc[512];
+static uint8_t strings[8];          // String indices the descriptors use
+static int nstrings;
+
+static void want_string (uint8_t index)
+{
+    if (index)
+        strings[nstrings++] = index;
+}
+
+static void check_device (const uint8_t *d, int n)
+{
+    CHECK(n == 18 && d[0] == 18 && d[1] == mDEVICE, "device descriptor: %d bytes", n);
+    CHECK((d[2] | d[3] << 8) == 0x0200, "bcdUSB 0x%04x", d[2] | d[3] << 8);
+    CHECK(d[7] == 8 || d[7] == 16 || d[7] == 32 || d[7] == 64,
+        "bMaxPacketSize0 %d", d[7]);
+    CHECK(d[17] == 1, "bNumConfigurations %d", d[17]);
+    want_string(d[14]);
+    want_string(d[15]);
+    want_string(d[16]);
+}
+
+// Walk the configuration: lengths add up, each interface has the
+// endpoints it announces, endpoint sizes are legal for full speed.
+// Records the packet sizes for the host
+static void check_config (const uint8_t *d, int n)
+{
+    int i, len, interfaces = 0, eps = 0, want = 0, num, in, size;
+
+    CHECK(n >= 9 && d[0] == 9 && d[1] == mCONFIGURATION, "configuration descriptor");
+    CHECK((d[2] | d[3] << 8) == n, "wTotalLength %d, %d bytes read", d[2] | d[3] << 8, n);
+    CHECK(d[5] != 0, "bConfigurationValue 0");
+    CHECK(d[7] & 0x80, "bmAttributes 0x%02x: bit 7 must be set", d[7]);
+    want_string(d[6]);
+
+    for (i = d[0]; i < n; i += len) {
+        len = d[i];
+        if (len < 2 || i + len > n) {
+            CHECK(0, "descriptor at %d: bLength %d overruns", i, len);
+            return;
+        }
+        switch (d[i + 1]) {
+            case mINTERFACE:
+                CHECK(len == 9, "interface descriptor of %d bytes", len);
+                CHECK(eps == want, "interface %d: %d endpoints, bNumEndpoints %d",
+                    interfaces - 1, eps, want);
+                CHECK(d[i + 2] == interfaces, "bInterfaceNumber %d", d[i + 2]);
+                interfaces++;
+                want = d[i + 4];
+                eps = 0;
+                want_string(d[i + 8]);
+                break;
+
+            case mENDPOINT:
+                CHECK(len == 7 && interfaces > 0, "endpoint descriptor at %d", i);
+                num = d[i + 2] & 0x0F;
+                in = d[i + 2] >> 7;
+                size = d[i + 4] | d[i + 5] << 8;
+                CHECK(num != 0 && host.maxp[num][in] == 0,
+                    "endpoint 0x%02x zero or repeated", d[i + 2]);
+                if ((d[i + 3] & 3) == 2)
+                    CHECK(size == 8 || size == 16 || size == 32 || size == 64,
+                        "bulk endpoint 0x%02x: %d bytes", d[i + 2], size);
+                else
+                    CHECK((d[i + 3] & 3) == 3 && size <= 64 && d[i + 6] != 0,
+                        "endpoint 0x%02x: type %d, %d bytes, interval %d",
+                        d[i + 2], d[i + 3] & 3, size, d[i + 6]);
+                host.maxp[num][in] = size;
+                eps++;
+                break;
+
+            case CS_INTERFACE:
+                CHECK(interfaces > 0, "functional descriptor outside an interface");
+                switch (d[i + 2]) {
+                    case DSC_FN_HEADER:     CHECK(len == 5, "CDC header: %d bytes", len);       break;
+                    case DSC_FN_CALL_MGT:   CHECK(len == 5, "CDC call mgmt: %d bytes", len);    break;
+                    case DSC_FN_ACM:        CHECK(len == 4, "CDC ACM: %d bytes", len);          break;
+                    case DSC_FN_UNION:      CHECK(len >= 5, "CDC union: %d bytes", len);        break;
+                    default:                CHECK(0, "CDC subtype 0x%02x", d[i + 2]);          break;
+                }
+                break;
+
+            default:
+                CHECK(0, "descriptor type 0x%02x at %d", d[i + 1], i);
+                break;
+        }
+    }
+    CHECK(eps == want, "interface %d: %d endpoints, bNumEndpoints %d",
+        interfaces - 1, eps, want);
+    CHECK(interfaces == d[4], "%d interfaces, bNumInterfaces %d", interfaces, d[4]);
+}
+
+static void check_string (const uint8_t *d, int n, int index)
+{
+    CHECK(n >= 2 && d[0] == n && d[1] == mSTRING && !(n & 1),
+        "string %d: %d bytes, bLength %d", index, n, d[0]);
+}
+
+static void test_enumerate (void)
+{
+    static const uint8_t coding[7] = { 0x80, 0x25, 0, 0, 0, 0, 8 };    // 9600 8N1
+    int i, n, total;
+
+    usb_init();
+    CHECK(usb->CONTROL & USB_CONTROL_DPPULLUPNONOTG_MASK, "no D+ pull-up");
+    CHECK(usb_model_nvic.ISER & (1u << (INT_USB0 - 16)), "USB interrupt disabled");
+    CHECK(usb->INTEN == USB_INTEN_USBRSTEN_MASK, "INTEN 0x%02x before reset", usb->INTEN);
+
+    // As Windows does: 64 bytes of device descriptor at address 0, reset
+    host.maxp[0][0] = host.maxp[0][1] = 8;
+    bus_reset();
+    n = control(0x80, mGET_DESC, 0x0100, 0, 64, desc);
+    CHECK(n == 18, "device descriptor at address 0: %d bytes", n);
+    host.maxp[0][0] = host.maxp[0][1] = desc[7];
+    bus_reset();
+
+    CHECK(control(0x00, mSET_ADDRESS, ADDRESS, 0, 0, NULL) == 0, "SET_ADDRESS");
+    CHECK(usb->ADDR == ADDRESS, "USB0_ADDR %d after the status stage", usb->ADDR);
+    host.addr = 0;
+    CHECK(control(0x80, mGET_DESC, 0x0100, 0, 18, desc) < 0, "answered on address 0");
+    host.addr = ADDRESS;
+
+    n = control(0x80, mGET_DESC, 0x0100, 0, 18, desc);
+    check_device(desc, n);
+
+    n = control(0x80, mGET_DESC, 0x0200, 0, 9, desc);
+    CHECK(n == 9, "configuration header: %d bytes", n);
+    total = desc[2] | desc[3] << 8;
+    CHECK(total <= (int) sizeof(desc), "wTotalLength %d", total);
+    n = control(0x80, mGET_DESC, 0x0200, 0, total, desc);
+    check_config(desc, n);
+    n = control(0x80, mGET_DESC, 0x0200, 0, 2 * 8, desc);
+    CHECK(n == 16, "whole packets up to wLength: %d bytes", n);
+
+    // A SETUP drops what is left of an unfinished control read
+    CHECK(setup(0x80, mGET_DESC, 0x0200, 0, total) == 0
+        && xact_retry(PID_IN, 0, desc, &n, 8) == ACK, "first packet of a control read");
+    n = control(0x80, mGET_DESC, 0x0100, 0, 18, desc);
+    CHECK(n == 18 && desc[1] == mDEVICE, "control read after an aborted one: %d bytes", n);
+
+    n = control(0x80, mGET_DESC, 0x0300, 0, 255, desc);
+    CHECK(n == 4 && desc[0] == 4 && desc[1] == mSTRING && desc[2] == 0x09 && desc[3] == 0x04,
+        "language IDs: %d bytes", n);
+    for (i = 0; i != nstrings; i++) {
+        n = control(0x80, mGET_DESC, 0x0300 | strings[i], 0x0409, 255, desc);
+        check_string(desc, n, strings[i]);
+    }
+    CHECK(control(0x80, mGET_DESC, 0x0310, 0x0409, 255, desc) < 0, "string 16: no STALL");
+    CHECK(!(usb->ENDPOINT[0].ENDPT & USB_ENDPT_EPSTALL_MASK), "endpoint 0 left stalled");
+    n = control(0x80, mGET_STATUS, 0, 0, 2, desc);
+    CHECK(n == 2 && desc[0] == 0 && desc[1] == 0, "GET_STATUS: %d bytes", n);
+
+    CHECK(control(0x00, mSET_CONFIG, 1, 0, 0, NULL) == 0, "SET_CONFIGURATION");
+    memset(host.toggle, 0, sizeof(host.toggle));
+    n = control(0x80, mGET_CONFIG, 0, 0, 1, desc);
+    CHECK(n == 1 && desc[0] == 1, "GET_CONFIGURATION");
+    for (i = 1; i != 16; i++) {
+        if (host.maxp[i][1])
+            CHECK(usb->ENDPOINT[i].ENDPT & USB_ENDPT_EPTXEN_MASK, "endpoint 0x%02x not enabled", 0x80 | i);
+        if (host.maxp[i][0])
+            CHECK(usb->ENDPOINT[i].ENDPT & USB_ENDPT_EPRXEN_MASK, "endpoint 0x%02x not enabled", i);
+    }
+
+    CHECK(control(0x21, SET_LINE_CODING, 0, 0, 7, (uint8_t *) coding) == 7, "SET_LINE_CODING");
+    n = control(0xA1, GET_LINE_CODING, 0, 0, 7, desc);
+    CHECK(n == 7 && memcmp(desc, coding, 7) == 0, "GET_LINE_CODING");
+
+    CHECK(!cdc_connected(), "connected before DTR");
+    CHECK(control(0x21, SET_CONTROL_LINE_STATE, 3, 0, 0, NULL) == 0, "SET_CONTROL_LINE_STATE");
+    CHECK(cdc_connected(), "not connected with DTR set");
+
+    // 3 ms of idle bus (suspend or cable out), then resume
+    usb->ISTAT |= USB_ISTAT_SLEEP_MASK;
+    irq();
+    CHECK(!cdc_connected(), "connected while suspended");
+    usb->ISTAT |= USB_ISTAT_RESUME_MASK;
+    irq();
+    CHECK(cdc_connected(), "not connected after resume");
+}
+
+// Reset, address, configuration and DTR, as the host driver does
+static void configure (void)
+{
+    bus_reset();
+    CHECK(control(0x00, mSET_ADDRESS, ADDRESS, 0, 0, NULL) == 0, "SET_ADDRESS");
+    host.addr = ADDRESS;
+    CHECK(control(0x00, mSET_CONFIG, 1, 0, 0, NULL) == 0, "SET_CONFIGURATION");
+    memset(host.toggle, 0, sizeof(host.toggle));
+    CHECK(control(0x21, SET_CONTROL_LINE_STATE, 1, 0, 0, NULL) == 0, "SET_CONTROL_LINE_STATE");
+}
+
+// -----------------------------------------------------------------------------
+// Bulk traffic
+
+#define CDC_EP      2
+#define STREAM_EP   3
+
+// Application side of the CDC pipe: writes from src, reads into dst
+static struct {
+    const uint8_t *data;
+    int len, done, chunk;
+} src;
+
+static struct {
+    uint8_t *data;
+    int len, done;
+} dst;
+
+static void app_cdc_write (void)
+{
+    int n = src.len - src.done;
+
+    if (n > src.chunk)
+        n = src.chunk;
+    if (n > 0)
+        src.done += cdc_write((const char *) src.data + src.done, n);
+}
+
+static void app_cdc_read (void)
+{
+    if (dst.done < dst.len)
+        dst.done += cdc_read((char *) dst.data + dst.done, dst.len - dst.done);
+}
+
+static void test_cdc_in (void)
+{
+    static uint8_t tx[2048], rx[2048];
+    uint32_t zlps, naks;
+    int i, n;
+
+    for (i = 0; i != sizeof(tx); i++)
+        tx[i] = rnd();
+
+    // A full last packet is closed by a ZLP, a short one is not
+    zlps = host.zlps;
+    CHECK(cdc_write((const char *) tx, 64) == 64, "cdc_write of a packet");
+    n = bulk_in(CDC_EP, rx, sizeof(rx), 2);
+    CHECK(n == 64 && memcmp(rx, tx, 64) == 0, "one packet: %d bytes", n);
+    n = bulk_in(CDC_EP, rx, sizeof(rx), 2);
+    CHECK(n == 0 && host.zlps == zlps + 1, "no ZLP after a full packet");
+    CHECK(cdc_write((const char *) tx, 10) == 10, "cdc_write of 10 bytes");
+    n = bulk_in(CDC_EP, rx, sizeof(rx), 2);
+    CHECK(n == 10 && memcmp(rx, tx, 10) == 0 && host.zlps == zlps + 1, "short packet: %d bytes", n);
+    naks = host.naks;
+    n = bulk_in(CDC_EP, rx, sizeof(rx), 2);
+    CHECK(n == 0 && host.naks == naks + 2, "idle bulk IN did not NAK");
+
+    // Four times the ring, written while the host reads
+    src.data = tx;
+    src.len = sizeof(tx);
+    src.done = 0;
+    src.chunk = 100;
+    app = app_cdc_write;
+    n = 0;
+    while (n < (int) sizeof(tx)) {
+        i = bulk_in(CDC_EP, rx + n, sizeof(rx) - n, 4);
+        if (i <= 0)
+            break;
+        n += i;
+    }
+    app = NULL;
+    CHECK(n == sizeof(tx) && memcmp(rx, tx, sizeof(tx)) == 0, "bulk IN: %d of %d bytes",
+        n, (int) sizeof(tx));
+    bulk_in(CDC_EP, rx, sizeof(rx), 1);         // Trailing ZLP, if any
+}
+
+static void test_cdc_out (void)
+{
+    static uint8_t tx[1024], rx[1024];
+    uint32_t naks = host.naks;
+    int i, n, more;
+
+    for (i = 0; i != sizeof(tx); i++)
+        tx[i] = rnd();
+
+    // Nobody reads: the device holds its OUT banks and NAKs before the
+    // ring can overflow
+    n = bulk_out(CDC_EP, tx, sizeof(tx), 3);
+    CHECK(n > 0 && n < 256 && host.naks > naks, "OUT without reads: %d bytes taken", n);
+    CHECK(cdc_available() == n, "%d bytes in the ring, %d acknowledged", cdc_available(), n);
+
+    // The application reads, cdc_read() gives the banks back
+    dst.data = rx;
+    dst.len = sizeof(rx);
+    dst.done = 0;
+    app = app_cdc_read;
+    more = bulk_out(CDC_EP, tx + n, sizeof(tx) - n, 3);
+    app_cdc_read();
+    app = NULL;
+    CHECK(n + more == sizeof(tx), "OUT: %d of %d bytes", n + more, (int) sizeof(tx));
+    CHECK(dst.done == sizeof(rx) && memcmp(rx, tx, sizeof(tx)) == 0,
+        "OUT: %d bytes read back", dst.done);
+}
+
+// Endpoint recipient requests: GET_STATUS, CLEAR_FEATURE(ENDPOINT_HALT)
+// with the IN toggle back to DATA0, a STALL for anything else
+static void test_endpoint (void)
+{
+    static const uint8_t tx[10] = "0123456789";
+    uint8_t rx[64], desc[2];
+    int n;
+
+    n = control(0x82, mGET_STATUS, 0, 0x80 | CDC_EP, 2, desc);
+    CHECK(n == 2 && desc[0] == 0 && desc[1] == 0, "GET_STATUS(0x82): %d bytes", n);
+    n = control(0x82, mGET_STATUS, 0, 0x00, 2, desc);
+    CHECK(n == 2 && desc[0] == 0, "GET_STATUS(0x00): %d bytes", n);
+    CHECK(control(0x82, mGET_STATUS, 0, 0x85, 2, desc) < 0, "GET_STATUS(0x85): no STALL");
+    CHECK(!(usb->ENDPOINT[0].ENDPT & USB_ENDPT_EPSTALL_MASK), "endpoint 0 left stalled");
+    CHECK(control(0x02, mSET_FEATURE, 0, 0x80 | CDC_EP, 0, NULL) < 0, "SET_FEATURE: no STALL");
+    CHECK(control(0x02, mCLR_FEATURE, 1, 0x80 | CDC_EP, 0, NULL) < 0,
+        "CLEAR_FEATURE(1): no STALL");
+
+    // Bring the IN toggle to DATA1, then clear the halt: DATA0 again
+    if (!host.toggle[CDC_EP][1]) {
+        cdc_write((const char *) tx, sizeof(tx));
+        bulk_in(CDC_EP, rx, sizeof(rx), 2);
+    }
+    CHECK(host.toggle[CDC_EP][1] == 1, "toggle setup");
+    CHECK(control(0x02, mCLR_FEATURE, 0, 0x80 | CDC_EP, 0, NULL) == 0,
+        "CLEAR_FEATURE(HALT, 0x82)");
+    host.toggle[CDC_EP][1] = 0;                 // The host resets its side too
+    cdc_write((const char *) tx, sizeof(tx));
+    n = bulk_in(CDC_EP, rx, sizeof(rx), 2);     // xact() checks DATA0
+    CHECK(n == sizeof(tx) && memcmp(rx, tx, n) == 0, "after CLEAR_FEATURE: %d bytes", n);
+
+    // A halted endpoint: reported, STALLs, and runs again once cleared
+    usb->ENDPOINT[CDC_EP].ENDPT |= USB_ENDPT_EPSTALL_MASK;
+    n = control(0x82, mGET_STATUS, 0, 0x80 | CDC_EP, 2, desc);
+    CHECK(n == 2 && desc[0] == 1 && desc[1] == 0, "GET_STATUS of a halted endpoint");
+    CHECK(bulk_in(CDC_EP, rx, sizeof(rx), 2) < 0, "halted endpoint did not STALL");
+    CHECK(control(0x02, mCLR_FEATURE, 0, 0x80 | CDC_EP, 0, NULL) == 0,
+        "CLEAR_FEATURE(HALT) of a halted endpoint");
+    host.toggle[CDC_EP][1] = 0;
+    n = control(0x82, mGET_STATUS, 0, 0x80 | CDC_EP, 2, desc);
+    CHECK(n == 2 && desc[0] == 0, "still halted after CLEAR_FEATURE");
+    cdc_write((const char *) tx, sizeof(tx));
+    n = bulk_in(CDC_EP, rx, sizeof(rx), 2);
+    CHECK(n == sizeof(tx) && memcmp(rx, tx, n) == 0, "after the halt: %d bytes", n);
+}
+
+static uint8_t *returned[16];
+static int nreturned;
+
+static void stream_done (uint8_t *data)
+{
+    returned[nreturned++ & 15] = data;
+}
+
+static void test_stream (void)
+{
+    static uint8_t blocks[5][512], rx[512];
+    uint32_t zlps = host.zlps;
+    int i, j, n;
+
+    for (i = 0; i != 5; i++)
+        for (j = 0; j != 512; j++)
+            blocks[i][j] = rnd();
+    usb_stream_callback(stream_done);
+    nreturned = 0;
+
+    for (i = 0; i != 4; i++)
+        CHECK(usb_stream_submit(blocks[i], 512) == 0, "submit block %d", i);
+    CHECK(usb_stream_submit(blocks[4], 512) < 0, "fifth block taken, the queue holds 4");
+    for (i = 0; i != 4; i++) {
+        n = bulk_in(STREAM_EP, rx, 512, 2);
+        CHECK(n == 512 && memcmp(rx, blocks[i], 512) == 0, "block %d: %d bytes", i, n);
+        CHECK(nreturned == i + 1 && returned[i] == blocks[i], "block %d not handed back", i);
+    }
+    n = bulk_in(STREAM_EP, rx, 512, 2);
+    CHECK(n == 0 && host.zlps == zlps, "stream ends a whole block with a ZLP");
+
+    // A partial last packet ends the block
+    CHECK(usb_stream_submit(blocks[4], 100) == 0, "submit 100 bytes");
+    n = bulk_in(STREAM_EP, rx, 512, 2);
+    CHECK(n == 100 && memcmp(rx, blocks[4], 100) == 0 && nreturned == 5,
+        "100 byte block: %d bytes", n);
+
+    // A bus reset hands queued blocks back, then the device enumerates again
+    usb_stream_submit(blocks[0], 512);
+    usb_stream_submit(blocks[1], 512);
+    CHECK(bulk_in(STREAM_EP, rx, 64, 2) == 64, "first packet of block 0");
+    bus_reset();
+    CHECK(nreturned == 7 && returned[5] == blocks[0] && returned[6] == blocks[1],
+        "reset kept %d blocks", 7 - nreturned);
+    CHECK(!cdc_connected(), "connected after reset");
+    CHECK(usb_stream_submit(blocks[0], 512) < 0, "stream taken before configuration");
+    configure();
+    CHECK(cdc_connected(), "not connected after enumerating again");
+}
+
+// -----------------------------------------------------------------------------
+// Simulated throughput
+
+static void report (const char *label, int count, int size, uint32_t frames,
+    uint32_t packets, uint32_t zlps)
+{
+    printf("  %-22s %7.1f %7.2f %5.2f\n", label, (double) count * size / frames,
+        (double) packets / count, (double) zlps / count);
+}
+
+static int submitted;
+
+static uint8_t stream_blocks[4][2048];
+static int stream_size;
+
+// Keeps the stream queue full
+static void app_stream (void)
+{
+    while (submitted - nreturned < 4
+            && usb_stream_submit(stream_blocks[submitted & 3], stream_size) == 0)
+        submitted++;
+}
+
+// Request/response on the CDC pipe: the application writes a reply of
+// 'size' bytes, the host reads it with a transfer of 'size' rounded up
+// to whole packets. A completed transfer is resubmitted in the next
+// frame, so the ZLP after a full last packet costs a frame of its own
+static void bench_cdc (int size)
+{
+    static uint8_t tx[4096], rx[4096 + 64];
+    uint32_t start, packets, zlps;
+    int count = 32768 / size, k, n, got;
+    char label[32];
+
+    if (count < 16)
+        count = 16;
+    next_frame();
+    start = host.frame;
+    packets = host.packets;
+    zlps = host.zlps;
+    for (k = 0; k != count; k++) {
+        src.data = tx;
+        src.len = size;
+        src.done = 0;
+        src.chunk = size;
+        app = app_cdc_write;
+        app_cdc_write();
+        for (got = 0; got < size; got += n) {
+            n = bulk_in(CDC_EP, rx, (size - got + 63) & ~63, 8);
+            if (n < 0) {
+                CHECK(0, "reply of %d bytes stalled", size);
+                return;
+            }
+            next_frame();
+        }
+        app = NULL;
+    }
+    bulk_in(CDC_EP, rx, 64, 1);
+    snprintf(label, sizeof(label), "cdc reply %d", size);
+    report(label, count, size, host.frame - start, host.packets - packets, host.zlps - zlps);
+}
+
+// Stream blocks of 'size' bytes, queue kept full. The host reads one
+// block per transfer; 'queued' transfers follow each other in the same
+// frame, otherwise the next one waits for the next frame
+static void bench_stream (int size, int queued)
+{
+    static uint8_t rx[2048 + 64];
+    uint32_t start, packets, zlps;
+    int count = 65536 / size, k, n;
+    char label[32];
+
+    stream_size = size;
+    submitted = nreturned = 0;
+    app = app_stream;
+    next_frame();
+    start = host.frame;
+    packets = host.packets;
+    zlps = host.zlps;
+    app_stream();
+    for (k = 0; k != count; k++) {
+        n = bulk_in(STREAM_EP, rx, (size + 63) & ~63, 8);
+        CHECK(n == size, "stream block %d: %d of %d bytes", k, n, size);
+        if (!queued)
+            next_frame();
+    }
+    app = NULL;
+    snprintf(label, sizeof(label), "stream %d, %s", size, queued ? "queued" : "one read");
+    report(label, count, size, host.frame - start + 1, host.packets - packets,
+        host.zlps - zlps);
+
+    // Drain what the application still queued
+    while (bulk_in(STREAM_EP, rx, sizeof(rx), 1) > 0)
+        ;
+}
+
+static void bench (void)
+{
+    static const int replies[] = { 1, 8, 63, 64, 65, 128, 512, 4096 };
+    static const int blocks[] = { 64, 100, 256, 512, 2048 };
+    unsigned i;
+
+    printf("simulated full speed: kB/s (bytes per frame), packets and ZLPs per transfer\n");
+    for (i = 0; i != sizeof(replies) / sizeof(replies[0]); i++)
+        bench_cdc(replies[i]);
+    for (i = 0; i != sizeof(blocks) / sizeof(blocks[0]); i++) {
+        bench_stream(blocks[i], 0);
+        bench_stream(blocks[i], 1);
+    }
+}
+
+int main (int argc, char **argv)
+{
+    pool_init();
+    test_enumerate();
+    test_cdc_in();
+    test_cdc_out();
+    test_endpoint();
+    test_stream();
+    printf("usbmodel: %d checks, %d failed\n", checks, failures);
+    if (!(argc > 1 && strcmp(argv[1], "-q") == 0))
+        bench();
+    return failures;
+}
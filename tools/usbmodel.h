@@ -0,0 +1,44 @@
+/**
+    \file usbmodel.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Host build of usb.c for the USB-FS controller model. Forced in
+    front of usb.c and ring.c (-include): the USB0, SIM and NVIC
+    register blocks become structs of tools/usbmodel.c, and the two
+    registers a plain struct cannot mimic go through the model: ISTAT
+    is write-one-to-clear, and USBRESET in USBTRC0 clears itself.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _USBMODEL_H_
+#define _USBMODEL_H_
+
+#define HOST_MODEL                      // common.h: no PRIMASK, no asm
+#define RAMFUNC_IN_FLASH                // No .ramfunc section on the host
+#define iprintf printf
+#define interrupt(kind) used            // ARM handler attribute
+
+#include <stdint.h>
+#include "OpenKL25Z.h"
+
+extern struct USB_MemMap usb_model_regs;
+extern struct SIM_MemMap usb_model_sim;
+extern struct NVIC_MemMap usb_model_nvic;
+
+#undef USB0_BASE_PTR
+#undef SIM_BASE_PTR
+#undef NVIC_BASE_PTR
+#define USB0_BASE_PTR   ((USB_MemMapPtr) &usb_model_regs)
+#define SIM_BASE_PTR    ((SIM_MemMapPtr) &usb_model_sim)
+#define NVIC_BASE_PTR   ((NVIC_MemMapPtr) &usb_model_nvic)
+
+volatile uint8_t *usb_model_usbtrc0 (void);
+void usb_model_istat_clear (uint8_t mask);
+
+#undef USB0_USBTRC0
+#define USB0_USBTRC0            (*usb_model_usbtrc0())
+#define USB_ISTAT_CLEAR(mask)   usb_model_istat_clear(mask)
+
+#endif  // _USBMODEL_H_
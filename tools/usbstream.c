@@ -0,0 +1,114 @@
+/**
+    \file usbstream.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Host reader for the vendor bulk stream of OpenKL25Z (Linux,
+    usbfs, no libusb). Reads fixed-size blocks from endpoint 0x83 of
+    interface 2, checks the sequence numbers and prints one line per
+    block: host time, sequence, device stamp (microseconds, wrapping
+    every 71 minutes), payload, drops and kind
+    (0 sensor snapshots, 1 power counters, 2 tone detector changes).
+    \note Usage: usbstream /dev/bus/usb/BBB/DDD [blocks]
+    (see lsusb for bus and device numbers, VID:PID dead:beaf).
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/usbdevice_fs.h>
+
+#define STREAM_INTERFACE    2
+#define STREAM_ENDPOINT     0x83
+#define STREAM_BLOCK_SIZE   512     // Must match stream.h
+#define TIMEOUT_MS          2000
+
+// Little endian block header, see stream_block_t
+static uint32_t get32 (const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t get16 (const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static double now (void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main (int argc, char **argv)
+{
+    uint8_t block[STREAM_BLOCK_SIZE];
+    struct usbdevfs_bulktransfer bulk;
+    unsigned int intf = STREAM_INTERFACE;
+    long count, limit = -1;
+    uint32_t seq, expect = 0;
+    unsigned long lost = 0, dropped = 0, bytes = 0;
+    double start, t;
+    int fd, n;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s /dev/bus/usb/BBB/DDD [blocks]\n", argv[0]);
+        return 1;
+    }
+    if (argc > 2)
+        limit = atol(argv[2]);
+
+    fd = open(argv[1], O_RDWR);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (ioctl(fd, USBDEVFS_CLAIMINTERFACE, &intf) < 0) {
+        perror("claim interface");
+        return 1;
+    }
+
+    bulk.ep = STREAM_ENDPOINT;
+    bulk.len = sizeof(block);
+    bulk.timeout = TIMEOUT_MS;
+    bulk.data = block;
+
+    start = now();
+    for (count = 0; limit < 0 || count < limit; count++) {
+        n = ioctl(fd, USBDEVFS_BULK, &bulk);
+        t = now() - start;
+        if (n < 0) {
+            perror("bulk");
+            break;
+        }
+        if (n != STREAM_BLOCK_SIZE) {
+            fprintf(stderr, "short block: %d bytes\n", n);
+            continue;
+        }
+        seq = get32(&block[0]);
+        if (count && seq != expect)
+            lost += seq - expect;
+        expect = seq + 1;
+        dropped += get16(&block[10]);
+        bytes += n;
+        printf("%.6f %lu %lu %u %u %u\n", t, (unsigned long) seq,
+            (unsigned long) get32(&block[4]), get16(&block[8]), get16(&block[10]),
+            get16(&block[12]));
+    }
+
+    t = now() - start;
+    fprintf(stderr, "%ld blocks, %lu lost, %lu samples dropped on device, %.1f kB/s\n",
+        count, lost, dropped, t > 0 ? bytes / t / 1000.0 : 0.0);
+    ioctl(fd, USBDEVFS_RELEASEINTERFACE, &intf);
+    close(fd);
+    return 0;
+}
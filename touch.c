@@ -1,6 +1,6 @@
 /**
  * \file touch.c
- * \brief Touch I/O
+ * \brief Touch I/O and slider engine
  * \date 2012-2013
  * \author Andrew Payne <andy@payne.org>
  * \license This file is released under the MIT License.
@@ -10,17 +10,47 @@
 #include <stdio.h>
 #include "freedom.h"
 #include "common.h"
+#include "profile.h"
+#include "touch.h"
 
 #define NCHANNELS 16
 static volatile uint16_t raw_counts[NCHANNELS];
-static volatile uint16_t base_counts[NCHANNELS];
+static volatile uint32_t base_counts[NCHANNELS];    // Baseline, Q4
 static uint32_t enable_mask;                    // Bitmask of enabled channels
+static uint8_t next_channel[NCHANNELS];         // Scan sequence, see touch_init()
+static uint8_t last_channel;                    // Highest enabled channel
+
+// Slider engine tuning, in TSI counts and full scans
+#define BASE_SHIFT      8       // Baseline IIR: 1/256 of the error per scan
+#define TOUCH_ON        200     // Sum of both deltas to report a touch
+#define TOUCH_OFF       100     // ... and to release it (hysteresis)
+#define DEBOUNCE        3       // Consecutive scans to confirm down or up
+#define MOVE_STEP       8       // Position change that raises touchMove
+#define IDLE_SCANS      2000    // Untouched full scans before going idle
+
+// Idle mode compares one electrode at a time against baseline + margin
+// (TSI out-of-range is TSICNT > THRESH), while a touch is judged on the
+// sum: lo + hi > TOUCH_ON, both deltas clamped at 0. The larger delta of
+// such a touch is then above TOUCH_ON / 2 wherever it lands between the
+// pads, so the margin is derived from TOUCH_ON: half of that bound,
+// as a guard for the baseline rounding and for a finger that moves
+// between the scans of the two electrodes
+#define IDLE_MARGIN     (TOUCH_ON / 4)
+
+#define QUEUE_LEN       8       // Power of two
+static touch_event_t queue[QUEUE_LEN];
+static volatile uint8_t queue_head, queue_tail; // Written by ISR / by reader
+
+static uint8_t pressed, position, debounce;
+static uint16_t idle_count;                     // Untouched full scans
+static volatile uint8_t idle;                   // Wake-on-touch mode
+static uint8_t idle_channel;                    // Channel armed while idle
 
 // Get current touch input value (normalized to baseline) for specififed 
 // input channel
 int touch_data(int channel)
 {
-    return raw_counts[channel] - base_counts[channel]; 
+    return raw_counts[channel] - (int)(base_counts[channel] >> 4); 
 }
 
 // Initiate a touch scan on the given channel
@@ -62,36 +92,198 @@ void touch_init(uint32_t channel_mask)
     // Read initial (baseline) values for each enabled channel
     int i, first_channel = 0;
     enable_mask = channel_mask;
+    if (enable_mask == 0)
+        return;
     for(i=15; i>=0; i--) {
         if((1 << i) & enable_mask) {
             scan_start(i);
             while(!(TSI0_GENCS & TSI_GENCS_EOSF_MASK))      // Wait until done
                 ;
 
-            base_counts[i] = scan_data();
+            base_counts[i] = scan_data() << 4;
             first_channel = i;
         }
     }
+
+    // Build the scan sequence once: each enabled channel points to the
+    // next enabled one, the last wraps to the first
+    int next = first_channel;
+    last_channel = first_channel;
+    for(i=15; i>=0; i--) {
+        if((1 << i) & enable_mask) {
+            next_channel[i] = next;
+            next = i;
+            if (i > last_channel)
+                last_channel = i;
+        }
+    }
     
     // Enable TSI interrupts and start the first scan
     enable_irq(INT_TSI0);
     scan_start(first_channel);
 }
 
+// Queue an event; it is dropped when the reader is QUEUE_LEN behind
+static void event_push(uint8_t type)
+{
+    uint8_t head = queue_head;
+    if ((uint8_t)(head - queue_tail) == QUEUE_LEN)
+        return;
+    queue[head & (QUEUE_LEN - 1)].stamp = sysTicks;
+    queue[head & (QUEUE_LEN - 1)].type = type;
+    queue[head & (QUEUE_LEN - 1)].pos = position;
+    queue_head = head + 1;
+}
+
+// Baseline IIR step for one channel. The step rounds to nearest on both
+// signs: a plain >> floors, so every negative error would pull the
+// baseline down while positive errors below 1 << BASE_SHIFT never
+// move it up
+inline static void base_track(int channel)
+{
+    int32_t err = ((uint32_t) raw_counts[channel] << 4) - base_counts[channel];
+    if (err >= 0)
+        base_counts[channel] += (err + (1 << (BASE_SHIFT - 1))) >> BASE_SHIFT;
+    else
+        base_counts[channel] -= (-err + (1 << (BASE_SHIFT - 1))) >> BASE_SHIFT;
+}
+
+// Slider processing, run once per full scan of the enabled channels
+static void slider_update(void)
+{
+    int lo = touch_data(TOUCH_CH_LOW);
+    int hi = touch_data(TOUCH_CH_HIGH);
+    int i, sum, touched;
+
+    if (lo < 0) lo = 0;
+    if (hi < 0) hi = 0;
+    sum = lo + hi;
+    touched = (sum > (pressed ? TOUCH_OFF : TOUCH_ON));
+
+    // Track drift only while nobody is touching
+    if (!touched && !pressed) {
+        for (i = 0; i < NCHANNELS; i++) {
+            if ((1 << i) & enable_mask)
+                base_track(i);
+        }
+        if (idle_count < IDLE_SCANS)
+            idle_count++;
+    }
+    else {
+        idle_count = 0;
+    }
+
+    if (touched != pressed) {
+        if (++debounce < DEBOUNCE)
+            return;
+        debounce = 0;
+        pressed = touched;
+        if (pressed) {
+            position = (255 * hi) / sum;        // The only divide per scan
+            event_push(touchDown);
+        }
+        else {
+            event_push(touchUp);
+        }
+        return;
+    }
+    debounce = 0;
+    if (pressed) {
+        uint8_t pos = (255 * hi) / sum;
+        if ((pos > position + MOVE_STEP) || (pos + MOVE_STEP < position)) {
+            position = pos;
+            event_push(touchMove);
+        }
+    }
+}
+
+// Arm the out-of-range threshold of a channel: baseline plus margin.
+// Only the channel being scanned is compared, so idle mode rotates the
+// enabled channels, one software-triggered scan per tick
+inline static void idle_arm(int channel)
+{
+    uint32_t high = (base_counts[channel] >> 4) + IDLE_MARGIN;
+    if (high > 0xFFFF)
+        high = 0xFFFF;
+    idle_channel = channel;
+    TSI0_TSHD = TSI_TSHD_THRESH(high) | TSI_TSHD_THRESL(0);
+    scan_start(channel);
+}
+
+// Stop continuous scanning: interrupt only on out-of-range results
+static void idle_enter(void)
+{
+    idle = TRUE;
+    TSI0_GENCS = (TSI0_GENCS & ~TSI_GENCS_ESOR_MASK) | TSI_GENCS_EOSF_MASK;
+    idle_arm(next_channel[last_channel]);
+}
+
+// Back to continuous end-of-scan interrupts
+static void idle_leave(void)
+{
+    idle = FALSE;
+    idle_count = 0;
+    TSI0_GENCS |= TSI_GENCS_ESOR_MASK | TSI_GENCS_OUTRGF_MASK;
+}
+
+// Periodic hook (SysTick): while idle, collect the last scan to keep
+// the baseline tracking drift and trigger the scan of the next channel
+void touch_tick(void)
+{
+    if (!idle || (TSI0_GENCS & TSI_GENCS_SCNIP_MASK))
+        return;
+    if (TSI0_GENCS & TSI_GENCS_EOSF_MASK) {
+        raw_counts[idle_channel] = scan_data();
+        base_track(idle_channel);
+    }
+    idle_arm(next_channel[idle_channel]);
+}
+
+// Get the oldest pending touch event; returns FALSE when there is none
+uint8_t touch_event_get(touch_event_t *ev)
+{
+    uint8_t tail = queue_tail;
+    if (tail == queue_head)
+        return FALSE;
+    *ev = queue[tail & (QUEUE_LEN - 1)];
+    queue_tail = tail + 1;
+    return TRUE;
+}
+
+// Debounced touch state
+uint8_t touch_pressed(void)
+{
+    return pressed;
+}
+
+// Last slider position, 0 at TOUCH_CH_LOW .. 255 at TOUCH_CH_HIGH
+uint8_t touch_position(void)
+{
+    return position;
+}
+
 // Touch input interrupt handler
 void TSI0_IRQHandler() __attribute__((interrupt("IRQ")));
-void TSI0_IRQHandler(void)
+RAMFUNC void TSI0_IRQHandler(void)
 {
+    PROF_ISR(profTSI0);
     // Save data for channel
     uint32_t channel = (TSI0_DATA & TSI_DATA_TSICH_MASK) >> TSI_DATA_TSICH_SHIFT;
     raw_counts[channel] = scan_data();
 
-    // Start a new scan on next enabled channel
-    for(;;) {
-        channel = (channel + 1) % NCHANNELS;
-        if ((1 << channel) & enable_mask) {
-            scan_start(channel);
+    // Out-of-range while idle: a finger is present, resume scanning
+    if (idle)
+        idle_leave();
+
+    // The last channel of the sequence completes a full scan
+    if (channel == last_channel) {
+        slider_update();
+        if (idle_count >= IDLE_SCANS) {
+            idle_enter();
             return;
         }
     }
+
+    // Start a new scan on next enabled channel
+    scan_start(next_channel[channel]);
 }
@@ -0,0 +1,50 @@
+/**
+    \file touch.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Touch slider engine: per-channel adaptive baselines, slider
+    position interpolated from the two electrodes and a queue of
+    debounced touch events filled from the TSI interrupt.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _TOUCH_H_
+#define _TOUCH_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Touch
+    @{
+*/
+
+#define TOUCH_CH_LOW        9       /**< Electrode at position 0 (PTB16).     */
+#define TOUCH_CH_HIGH       10      /**< Electrode at position 255 (PTB17).   */
+#define TOUCH_POS_MID       128     /**< Half of the slider.                  */
+
+/** \brief Kind of touch event. */
+enum touchEvent
+{
+    touchDown = 1,                  /**< Finger landed (debounced).           */
+    touchMove,                      /**< Position changed while pressed.      */
+    touchUp                         /**< Finger released (debounced).         */
+};
+
+/** \brief Entry of the touch event queue. */
+typedef struct {
+    uint32_t stamp;                 /**< sysTicks when the event was raised.  */
+    uint8_t  type;                  /**< \ref touchEvent.                     */
+    uint8_t  pos;                   /**< Slider position, 0..255.             */
+} touch_event_t;
+
+uint8_t touch_event_get (touch_event_t *ev);
+uint8_t touch_pressed (void);
+uint8_t touch_position (void);
+void touch_tick (void);
+
+/** @} */ // Touch
+
+#endif  // _TOUCH_H_
@@ -0,0 +1,84 @@
+/**
+    \file trace.c
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Deferred binary trace. Recording is a masked store of four
+    words (about 30 cycles); when the ring is full new records are
+    dropped and counted, so the oldest context is kept.
+    \note A host tool can decode a RAM dump of the ring with the
+    .trace_fmt section of the ELF file: the offsets index into it.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#include <stdio.h>
+#include "freedom.h"
+#include "common.h"
+#include "timebase.h"
+#include "trace.h"
+
+static trace_record_t ring[TRACE_LEN];
+static volatile uint8_t head, tail;     // Write (any context) / read
+static uint16_t seq;
+static volatile uint16_t lost;
+
+/**
+    \brief Store a record; use through \ref TRACE.
+*/
+void trace_put (uint16_t fmt, uint32_t a, uint32_t b)
+{
+    uint32_t primask = __irq_save();
+    uint8_t h = head;
+
+    if ((uint8_t)(h - tail) == TRACE_LEN) {
+        lost++;
+    }
+    else {
+        trace_record_t *r = &ring[h & (TRACE_LEN - 1)];
+        r->stamp = time_us32();
+        r->fmt = fmt;
+        r->seq = seq++;
+        r->a = a;
+        r->b = b;
+        head = h + 1;
+    }
+    __irq_restore(primask);
+}
+
+/**
+    \brief Take the oldest record.
+    \return TRUE when a record was copied.
+*/
+uint8_t trace_get (trace_record_t *rec)
+{
+    uint8_t t = tail;
+    if (t == head)
+        return FALSE;
+    *rec = ring[t & (TRACE_LEN - 1)];
+    tail = t + 1;
+    return TRUE;
+}
+
+/**
+    \return Records dropped since the last call.
+*/
+uint16_t trace_lost (void)
+{
+    uint32_t primask = __irq_save();
+    uint16_t n = lost;
+    lost = 0;
+    __irq_restore(primask);
+    return n;
+}
+
+/**
+    \brief Format a record on the console.
+*/
+void trace_print (const trace_record_t *rec)
+{
+    iprintf("[%4lu.%06lu] ", (unsigned long) (rec->stamp / 1000000),
+        (unsigned long) (rec->stamp % 1000000));
+    iprintf(__trace_fmt_start + rec->fmt, rec->a, rec->b);
+    iprintf("\r\n");
+}
@@ -0,0 +1,59 @@
+/**
+    \file trace.h
+    \version 0.1.0
+    \date 2026-10-18
+    \brief Deferred binary trace: interrupt handlers store fixed-size
+    records (format id, stamp, two arguments) in a RAM ring; the text is
+    only produced later, outside of interrupt context.
+    \author Nelson Lombardo
+    \license This file is released under the MIT License.
+    \include LICENSE
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+    \addtogroup Trace
+    @{
+*/
+
+#define TRACE_LEN   32              /**< Records in the ring, power of two.     */
+
+/** \brief One trace record, 16 bytes. */
+typedef struct {
+    uint32_t stamp;                 /**< time_us32() when it was recorded.      */
+    uint16_t fmt;                   /**< Offset of the format in .trace_fmt.    */
+    uint16_t seq;                   /**< Record counter, low 16 bits.           */
+    uint32_t a;
+    uint32_t b;
+} trace_record_t;
+
+/** From the linker script: the interned format strings. */
+extern const char __trace_fmt_start[];
+
+/**
+    \brief Record an event. The format string is interned in the
+    .trace_fmt flash section at compile time; the record only keeps its
+    offset. The format may use up to two 32-bit arguments and carries no
+    line ending.
+*/
+#define TRACE(fmt, a, b)                                                    \
+    do {                                                                    \
+        static const char _trace_fmt[]                                      \
+            __attribute__((section(".trace_fmt"))) = fmt;                   \
+        trace_put(_trace_fmt - __trace_fmt_start,                           \
+            (uint32_t)(a), (uint32_t)(b));                                  \
+    } while (0)
+
+void trace_put (uint16_t fmt, uint32_t a, uint32_t b);
+uint8_t trace_get (trace_record_t *rec);
+uint16_t trace_lost (void);
+void trace_print (const trace_record_t *rec);
+
+/** @} */ // Trace
+
+#endif  // _TRACE_H_
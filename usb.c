@@ -12,10 +12,9 @@
 #include "freedom.h"
 #include "common.h"
 #include "usb.h"
-
-// *******************************************************
-//  TODO:  INCOMPLETE, work in progress
-// *******************************************************
+#include "pool.h"
+#include "profile.h"
+#include "trace.h"
 
 // USB Buffer table, the primary interface to the USB hardware module
 typedef struct USB_BDT {
@@ -40,6 +39,12 @@ typedef struct USB_BDT {
 #define _DATA01         (1 << 6)        // DATA0/1 flag
 #define _OWN            (1 << 7)        // USB controller owns buffer
 
+// Interrupt flags are write-one-to-clear; the host model of the
+// controller (tools/usbmodel.h) supplies its own clear
+#ifndef USB_ISTAT_CLEAR
+#define USB_ISTAT_CLEAR(mask)   (USB0_ISTAT = (mask))
+#endif
+
 // Token codes for PID field
 #define SETUP_TOKEN    0x0D
 #define OUT_TOKEN      0x01
@@ -56,21 +61,38 @@ static inline USB_BDT *bdt_tx(int num) { return bdt_rx(num) + (BDT_PER_EP / 2);}
 #define EP0_BUFSIZE 8
 static uint8_t ep0_rx_buffers[2][EP0_BUFSIZE] __attribute__ ((aligned(4)));
 
+// Receive handlers return non-zero to keep the buffer: it stays owned by
+// the CPU, so the controller NAKs further OUT tokens (flow control)
 typedef struct endpoint {
     uint8_t num;
     uint8_t data0;
     uint8_t tx_next;
     uint8_t tx_last;
+    uint8_t zlp;                    // Pending transfer ends with a ZLP
+    uint16_t size;                  // wMaxPacketSize
     uint16_t pending_len;
     uint8_t *pending_data;
-    void (*rx_handler)(struct endpoint *ep, uint8_t *data, int len);
+    int (*rx_handler)(struct endpoint *ep, uint8_t *data, int len);
+    void (*tx_handler)(struct endpoint *ep, struct USB_BDT *bdt_ptr);
 } endpoint_t;
 static endpoint_t endpoints[MAX_ENDPOINTS];
 
+// CDC bulk OUT buffers held back while the receive ring is short of
+// space, in the order the controller will expect them
+static USB_BDT *cdc_rx_held[2];
+static uint8_t cdc_rx_nheld;
+
+// CDC packet buffers, one per BDT bank, taken from the pool by usb_init()
+static uint8_t *cdc_tx_packets[2];
+static uint8_t *cdc_rx_packets[2];
+static uint8_t *cdc_acm_packets[2];
+
 // Current USB device state
 enum { POWER, ENUMERATED, ENABLED, ADDRESS, READY };
-static int device_state;
+static volatile int device_state;
 static uint8_t device_address;
+static volatile uint16_t line_state;    // SET_CONTROL_LINE_STATE: DTR, RTS
+static volatile uint8_t suspended;      // Bus idle: host suspended or cable out
 
 static const USB_DEV_DSC device_descriptor = {
     .bLength        = sizeof(USB_DEV_DSC),
@@ -97,7 +119,14 @@ static const USB_DEV_DSC device_descriptor = {
 #define CDC_ACM_SIZE          16
 #define CDC_RX_SIZE           64
 #define CDC_TX_SIZE           64
-#define NUM_INTERFACE         2
+#define STREAM_INTERFACE      2
+#define STREAM_ENDPOINT       3
+#define STREAM_SIZE           64
+#define NUM_INTERFACE         3
+
+// CDC data buffering (ring sizes, bytes)
+#define CDC_TX_BUFLEN         512
+#define CDC_RX_BUFLEN         256
 
 
 // Configuration descriptor
@@ -112,6 +141,8 @@ typedef struct USB_CONFIG {
     USB_INTF_DSC            i7;
     USB_EP_DSC              i8;
     USB_EP_DSC              i9;
+    USB_INTF_DSC            i10;
+    USB_EP_DSC              i11;
 } __attribute__((packed)) USB_CONFIG;
 
 static const USB_CONFIG config_descriptor = {
@@ -119,7 +150,7 @@ static const USB_CONFIG config_descriptor = {
         .bLength        = sizeof(USB_CFG_DSC),
         .bDscType       = mCONFIGURATION,
         .wTotalLength   = sizeof(USB_CONFIG),
-        .bNumIntf       = 2,
+        .bNumIntf       = NUM_INTERFACE,
         .bCfgValue      = 1,
         .iCfg           = 0,
         .bmAttributes   = 0xC0,
@@ -187,7 +218,24 @@ static const USB_CONFIG config_descriptor = {
         .bmAttributes   = 0x02,
         .wMaxPktSize    = CDC_TX_SIZE,
         .bInterval      = 0
-    }       
+    },{
+        .bLength        = sizeof(USB_INTF_DSC),
+        .bDscType       = mINTERFACE,
+        .bIntfNum       = STREAM_INTERFACE,
+        .bAltSetting    = 0,
+        .bNumEPs        = 1,
+        .bIntfCls       = 0xFF,         // Vendor specific
+        .bIntfSubCls    = 0x00,
+        .bIntfProtocol  = 0,
+        .iIntf          = 0
+    },{
+        .bLength        = sizeof(USB_EP_DSC),
+        .bDscType       = mENDPOINT,
+        .bEPAdr         = STREAM_ENDPOINT | 0x80,
+        .bmAttributes   = 0x02,
+        .wMaxPktSize    = STREAM_SIZE,
+        .bInterval      = 0
+    }
 };
 
 // USB string tables
@@ -260,6 +308,19 @@ void usb_dump(void)
 
 void usb_init(void)
 {
+    int i;
+
+    // CDC packet buffers, kept for good: the four bulk ones are the
+    // whole packet class of the pool, the notification ones go to the
+    // small class.  Call after pool_init()
+    for(i = 0; i != 2; i++) {
+        cdc_tx_packets[i] = pool_alloc(CDC_TX_SIZE);
+        cdc_rx_packets[i] = pool_alloc(CDC_RX_SIZE);
+        cdc_acm_packets[i] = pool_alloc(CDC_ACM_SIZE);
+        if(!cdc_tx_packets[i] || !cdc_rx_packets[i] || !cdc_acm_packets[i])
+            fault(0b10101110);                  // Heap too small for the pools
+    }
+
     device_state = POWER;
     
     // Enable USB clocks
@@ -277,7 +338,7 @@ void usb_init(void)
     USB0_BDTPAGE3 = (uint8_t)((uint32_t)bdt >> 24);
     
     // Clear any pending interrupts, and enable just the reset interrupt
-    USB0_ISTAT = 0xff;
+    USB_ISTAT_CLEAR(0xff);
     USB0_INTEN = USB_INTEN_USBRSTEN_MASK;
     
     // Disable weak pull downs, take out of suspend state
@@ -305,6 +366,11 @@ static void usb_init_ep(int num, int buflen, uint8_t *rx_buf0, uint8_t *rx_buf1)
     endpoint_t *ep = &endpoints[num];
 
     ep->num = num;
+    ep->size = buflen;
+    ep->data0 = 0;
+    ep->pending_len = 0;
+    ep->rx_handler = NULL;
+    ep->tx_handler = NULL;
     ep_clear_tx(ep, 1);
     
     // Configure BDT entries for receive
@@ -319,16 +385,23 @@ static void usb_init_ep(int num, int buflen, uint8_t *rx_buf0, uint8_t *rx_buf1)
                         | USB_ENDPT_EPHSHK_MASK;
 }
 
+static void stream_reset(void);
+
 static void usb_reset(void)
 {
     USB0_CTL |= USB_CTL_ODDRST_MASK;
+    device_state = POWER;
+    line_state = 0;
+    suspended = 0;
+    cdc_rx_nheld = 0;
+    stream_reset();
 
     // Configure endpoint 0 (the control endpoint)
     usb_init_ep(0, EP0_BUFSIZE, ep0_rx_buffers[0], ep0_rx_buffers[1]);
 
     // Clear all error and interrupt flags
     USB0_ERRSTAT = 0xFF;
-    USB0_ISTAT = 0xFF;
+    USB_ISTAT_CLEAR(0xFF);
 
     // Set default USB address
     USB0_ADDR = 0x00;
@@ -338,7 +411,8 @@ static void usb_reset(void)
 
     // Enable USB interrupts
     USB0_INTEN = USB_INTEN_TOKDNEEN_MASK | USB_INTEN_ERROREN_MASK 
-                    | USB_INTEN_USBRSTEN_MASK | USB_INTEN_STALLEN_MASK;
+                    | USB_INTEN_USBRSTEN_MASK | USB_INTEN_STALLEN_MASK
+                    | USB_INTEN_SLEEPEN_MASK;
 }
 
 // Get BDT for next available TX buffer for endpoint
@@ -347,14 +421,15 @@ inline static USB_BDT *ep_next_tx(endpoint_t *ep)
     return bdt_tx(ep->num) + ep->tx_next;
 }
 
-// Send a bufffer for a given endpoint
-static int usb_tx(endpoint_t *ep, uint8_t *data, int len)
+// Send a bufffer for a given endpoint.  Returns -1 if both buffers are
+// owned by the controller
+static RAMFUNC int usb_tx(endpoint_t *ep, uint8_t *data, int len)
 {
     USB_BDT *bdt_ptr = ep_next_tx(ep);
 
     // Check to see if the next tx buffer is free   
     if (bdt_ptr->stat._byte & _OWN)
-        return 0;
+        return -1;
         
     bdt_ptr->count = len;
     bdt_ptr->addr = data;
@@ -366,46 +441,247 @@ static int usb_tx(endpoint_t *ep, uint8_t *data, int len)
     return len;
 }
 
-static void usb_tx_handler(endpoint_t *ep, USB_BDT *bdt_ptr)
+static RAMFUNC void usb_tx_handler(endpoint_t *ep)
 {
     int len;
 
-    // Queue any pending data transfers
+    // Queue any pending data transfers, in wMaxPacketSize chunks
     while(ep->pending_len > 0) {
-        len = min(ep->pending_len, EP0_BUFSIZE);
-        if(!usb_tx(ep, ep->pending_data, len))          // No more transmit buffers
-            break;
+        len = min(ep->pending_len, ep->size);
+        if(usb_tx(ep, ep->pending_data, len) < 0)       // No more transmit buffers
+            return;
     
         ep->pending_len -= len;
         ep->pending_data += len;
     }
+
+    // A transfer that is a multiple of the packet size, and shorter than
+    // what the host asked for, is terminated by a zero length packet
+    if(ep->zlp && usb_tx(ep, 0, 0) >= 0)
+        ep->zlp = 0;
 }
 
-// Queue a buffer for sending over a given endpoint
-static void usb_queue_tx(endpoint_t *ep, uint8_t *data, int len)
+// Queue a buffer for sending over a given endpoint.  'maxlen' is the
+// length requested by the host
+static void usb_queue_tx(endpoint_t *ep, uint8_t *data, int len, int maxlen)
 {
+    if (len > maxlen)
+        len = maxlen;
     ep->pending_data = data;
     ep->pending_len = len;
-    usb_tx_handler(ep, NULL);
+    ep->zlp = (len < maxlen) && ((len & (ep->size - 1)) == 0);
+    usb_tx_handler(ep);
+}
+
+// -----------------------------------------------------------------------------------
+// CDC data interface: ring buffered, with both bulk buffers (ping-pong)
+// kept busy while there is data
+
+static uint8_t _cdc_tx_buffer[sizeof(RingBuffer) + CDC_TX_BUFLEN] __attribute__ ((aligned(4)));
+static uint8_t _cdc_rx_buffer[sizeof(RingBuffer) + CDC_RX_BUFLEN] __attribute__ ((aligned(4)));
+static RingBuffer *const cdc_tx_buffer = (RingBuffer *) &_cdc_tx_buffer;
+static RingBuffer *const cdc_rx_buffer = (RingBuffer *) &_cdc_rx_buffer;
+
+// Bulk IN packets, one per BDT bank: a bank is only refilled once the
+// controller has given it back (from the pool, see usb_init())
+static uint8_t cdc_tx_zlp;                      // Last packet was full size
+
+// Fill every free bulk IN bank from the transmit ring
+static RAMFUNC void cdc_tx_handler(endpoint_t *ep, USB_BDT *bdt_ptr)
+{
+    int len;
+
+    while(!(ep_next_tx(ep)->stat._byte & _OWN)) {
+        len = buf_len(cdc_tx_buffer);
+        if(len == 0) {
+            if(cdc_tx_zlp)                      // Terminate the transfer
+                usb_tx(ep, 0, 0);
+            cdc_tx_zlp = 0;
+            return;
+        }
+        uint8_t *pkt = cdc_tx_packets[ep->tx_next];
+        len = buf_read(cdc_tx_buffer, pkt, CDC_TX_SIZE);
+        usb_tx(ep, pkt, len);
+        cdc_tx_zlp = (len == CDC_TX_SIZE);
+    }
+}
+
+// Bulk OUT: the ring always has room for this packet, see below
+static RAMFUNC int cdc_rx_handler(endpoint_t *ep, uint8_t *data, int len)
+{
+    buf_write(cdc_rx_buffer, data, len);
+
+    // Banks alternate, so the other one may still deliver a packet
+    // before we react: hold this one unless two more packets fit
+    return buf_free(cdc_rx_buffer) < 2 * CDC_RX_SIZE;
 }
 
-static void cdc_rx_handler(endpoint_t *ep, uint8_t *data, int len)
+// -----------------------------------------------------------------------------------
+// Vendor bulk IN stream: submitted blocks are sent in place, each BDT
+// entry points into the caller's buffer (no copy).  A block that is a
+// multiple of STREAM_SIZE has no ZLP: the host reads fixed-size blocks
+
+#define STREAM_QUEUE    4                       // Power of two
+
+static struct {
+    uint8_t  *data;
+    uint16_t len;
+} stream_queue[STREAM_QUEUE];
+static volatile uint8_t stream_head;            // Next slot to submit
+static volatile uint8_t stream_tail;            // Oldest block not yet acknowledged
+static uint8_t stream_next;                     // Block being handed to the controller
+static uint16_t stream_offset;                  // ... and bytes of it already handed
+
+// Packets owned by the controller, oldest first: queue slot, with
+// STREAM_LAST on the packet that completes its block
+#define STREAM_LAST     0x80
+static uint8_t stream_inflight[2];
+static uint8_t stream_ninflight;
+
+static void (*stream_done)(uint8_t *data);
+
+// Give every queued block back to its owner
+static void stream_reset(void)
 {
-    // TODO:  proper echo handler without a buffer race
-    usb_tx(ep, data, len);
+    while (stream_tail != stream_head) {
+        if (stream_done)
+            stream_done(stream_queue[stream_tail & (STREAM_QUEUE - 1)].data);
+        stream_tail++;
+    }
+    stream_next = stream_tail;
+    stream_offset = 0;
+    stream_ninflight = 0;
+}
+
+static RAMFUNC void stream_tx_handler(endpoint_t *ep, USB_BDT *bdt_ptr)
+{
+    uint8_t slot;
+    int len;
+
+    // One packet acknowledged; banks complete in the order they were queued
+    if (bdt_ptr && stream_ninflight) {
+        slot = stream_inflight[0];
+        stream_inflight[0] = stream_inflight[1];
+        stream_ninflight--;
+        if (slot & STREAM_LAST) {
+            stream_tail++;
+            if (stream_done)
+                stream_done(stream_queue[slot & (STREAM_QUEUE - 1)].data);
+        }
+    }
+
+    while (stream_next != stream_head && !(ep_next_tx(ep)->stat._byte & _OWN)) {
+        slot = stream_next & (STREAM_QUEUE - 1);
+        len = min(stream_queue[slot].len - stream_offset, STREAM_SIZE);
+        usb_tx(ep, stream_queue[slot].data + stream_offset, len);
+        stream_offset += len;
+        if (stream_offset >= stream_queue[slot].len) {
+            slot |= STREAM_LAST;
+            stream_next++;
+            stream_offset = 0;
+        }
+        stream_inflight[stream_ninflight++] = slot;
+    }
+}
+
+// Set the function that gets each block back once the host has read it
+// (called from the USB interrupt)
+void usb_stream_callback(void (*done)(uint8_t *data))
+{
+    stream_done = done;
+}
+
+// Queue a block for the vendor bulk IN endpoint.  The buffer must stay
+// untouched until it is handed back.  Returns -1 if the device is not
+// configured or the queue is full
+int usb_stream_submit(uint8_t *data, uint16_t len)
+{
+    uint32_t primask;
+    uint8_t head = stream_head;
+
+    if (device_state != ENUMERATED || len == 0)
+        return -1;
+    if ((uint8_t)(head - stream_tail) == STREAM_QUEUE)
+        return -1;
+    stream_queue[head & (STREAM_QUEUE - 1)].data = data;
+    stream_queue[head & (STREAM_QUEUE - 1)].len = len;
+    primask = __irq_save();
+    stream_head = head + 1;
+    stream_tx_handler(&endpoints[STREAM_ENDPOINT], NULL);
+    __irq_restore(primask);
+    return 0;
 }
 
 // TODO:  move this to a CDC-specific file
 static void usb_set_config(uint16_t value)
 {
-    static uint8_t ep1_rx_buffers[2][CDC_ACM_SIZE] __attribute__ ((aligned(4)));
-    static uint8_t ep2_rx_buffers[2][CDC_RX_SIZE] __attribute__ ((aligned(4)));
-    
-    usb_init_ep(1, CDC_ACM_SIZE, ep1_rx_buffers[0], ep1_rx_buffers[1]);
-    usb_init_ep(2, CDC_RX_SIZE, ep2_rx_buffers[0], ep2_rx_buffers[1]);
+    buf_reset(cdc_tx_buffer, CDC_TX_BUFLEN);
+    buf_reset(cdc_rx_buffer, CDC_RX_BUFLEN);
+    cdc_tx_zlp = 0;
+    cdc_rx_nheld = 0;
+
+    usb_init_ep(1, CDC_ACM_SIZE, cdc_acm_packets[0], cdc_acm_packets[1]);
+    usb_init_ep(2, CDC_RX_SIZE, cdc_rx_packets[0], cdc_rx_packets[1]);
     endpoints[2].rx_handler = cdc_rx_handler;
+    endpoints[2].tx_handler = cdc_tx_handler;
+
+    stream_reset();
+    usb_init_ep(3, STREAM_SIZE, NULL, NULL);
+    bdt_rx(3)[0].stat._byte = bdt_rx(3)[1].stat._byte = 0;     // IN only
+    USB0_ENDPT(3) = USB_ENDPT_EPTXEN_MASK | USB_ENDPT_EPHSHK_MASK;
+    endpoints[3].tx_handler = stream_tx_handler;
+}
+
+// Queue data for the host; returns the number of bytes accepted, 0 if
+// the port is not configured or the ring is full
+int cdc_write(const char *p, int len)
+{
+    uint32_t primask;
+
+    if (device_state != ENUMERATED)
+        return 0;
+    len = buf_write(cdc_tx_buffer, (const uint8_t *) p, len);
+    primask = __irq_save();
+    cdc_tx_handler(&endpoints[CDC_TX_ENDPOINT], NULL);
+    __irq_restore(primask);
+    return len;
 }
 
+// Read received data without blocking; returns the number of bytes read
+int cdc_read(char *p, int len)
+{
+    uint32_t primask;
+
+    len = buf_read(cdc_rx_buffer, (uint8_t *) p, len);
+
+    // Give held buffers back to the controller once there is room
+    primask = __irq_save();
+    while (cdc_rx_nheld && buf_free(cdc_rx_buffer) >= 2 * CDC_RX_SIZE) {
+        cdc_rx_held[0]->count = CDC_RX_SIZE;
+        cdc_rx_held[0]->stat._byte = _OWN;
+        cdc_rx_held[0] = cdc_rx_held[1];
+        cdc_rx_nheld--;
+    }
+    __irq_restore(primask);
+    return len;
+}
+
+int cdc_available(void)
+{
+    return buf_len(cdc_rx_buffer);
+}
+
+// Configured, the host has the port open (DTR set) and the bus is not
+// suspended.  Unplugging the cable shows up as a suspend (the bus idles
+// in J): the state is then only cleared by the reset of the next attach
+int cdc_connected(void)
+{
+    return (device_state == ENUMERATED) && (line_state & 0x01) && !suspended;
+}
+
+static const uint16_t status_zero = 0;      // Bus powered, no remote wakeup
+static uint8_t device_config;
+
 static void usb_setup_device(endpoint_t *ep, USB_SETUP *setup)
 {
     const usb_descriptor_list_t *p;
@@ -421,13 +697,22 @@ static void usb_setup_device(endpoint_t *ep, USB_SETUP *setup)
                     else
                         len = p->length;
                         
-                    iprintf("sending 0x%04x %d\r\n",setup->wValue, len);
-                    usb_queue_tx(ep, p->addr, min(len, setup->wLength));
+                    TRACE("usb: descriptor 0x%04lx, %lu bytes", setup->wValue, len);
+                    usb_queue_tx(ep, p->addr, len, setup->wLength);
                     return;
                 }
                 p++;
             }
-            iprintf("NOT IMPLEMENTED! 0x%04x\r\n", setup->wValue);              
+            TRACE("usb: no descriptor 0x%04lx", setup->wValue, 0);
+            USB0_ENDPT0 |= USB_ENDPT_EPSTALL_MASK;      // Request error
+            break;
+
+        case mGET_STATUS:
+            usb_queue_tx(ep, (uint8_t *) &status_zero, 2, setup->wLength);
+            break;
+
+        case mGET_CONFIG:
+            usb_queue_tx(ep, (uint8_t *) &device_config, 1, setup->wLength);
             break;
             
         case mSET_ADDRESS:
@@ -437,14 +722,16 @@ static void usb_setup_device(endpoint_t *ep, USB_SETUP *setup)
             break;
             
         case mSET_CONFIG:
-            iprintf("setconfig: %d\r\n", setup->wValue);
+            TRACE("usb: set config %lu", setup->wValue, 0);
+            device_config = setup->wValue;
             device_state = ENUMERATED;
             usb_set_config(setup->wValue);
             usb_tx(ep,0,0);                         // Send handshake
             break;
             
         default:
-            iprintf("NOT IMPLEMENTED! %d\r\n", setup->bRequest);
+            TRACE("usb: unsupported device request %lu", setup->bRequest, 0);
+            USB0_ENDPT0 |= USB_ENDPT_EPSTALL_MASK;
             break;
     }
 }
@@ -456,60 +743,105 @@ typedef struct {
     uint8_t   CharFormat;
     uint8_t   ParityType;
     uint8_t   Databits;
-} cdc_line_coding_t;
+} __attribute__((packed)) cdc_line_coding_t;
 
-static cdc_line_coding_t line_coding;
+static cdc_line_coding_t line_coding = { 115200, 0, 0, 8 };
 
-static void rx_send_handshake(endpoint_t *ep, uint8_t *data, int len)
+// Data stage of SET_LINE_CODING.  The line coding is only reported back
+// to the host: the bulk pipe runs at full USB speed regardless
+static int rx_line_coding(endpoint_t *ep, uint8_t *data, int len)
 {
-    // NOTE:  Receive data is ignored
+    memcpy(&line_coding, data, min(len, sizeof(line_coding)));
     usb_tx(ep,0,0);                             // Send handshake
     ep->rx_handler = NULL;  
+    return 0;
 }
 
 static void usb_setup_interface(endpoint_t *ep, USB_SETUP *setup)
 {
     switch(setup->bRequest) {
         case GET_LINE_CODING:
-            usb_queue_tx(ep, (uint8_t *) &line_coding, sizeof(line_coding));
+            usb_queue_tx(ep, (uint8_t *) &line_coding, sizeof(line_coding), setup->wLength);
             break;
             
         case SET_LINE_CODING:
-            ep->rx_handler = rx_send_handshake;
+            ep->rx_handler = rx_line_coding;
             break;
             
         case SET_CONTROL_LINE_STATE:
-            usb_tx(ep,0,0);             // XXX: check this
+            line_state = setup->wValue;     // Bit 0: DTR, bit 1: RTS
+            usb_tx(ep,0,0);                 // Status stage
             break;
             
         default:
-            iprintf("setup_interface: %d\r\n", setup->bRequest);
+            TRACE("usb: unsupported interface request %lu", setup->bRequest, 0);
+            USB0_ENDPT0 |= USB_ENDPT_EPSTALL_MASK;
             break;      
     }   
 }
 
+#define ENDPOINT_HALT   0                       // Feature selector
+static uint16_t endpoint_status;                // GET_STATUS reply, bit 0: halted
+
 static void usb_setup_endpoint(endpoint_t *ep, USB_SETUP *setup)
 {
-    iprintf("setup_endpoint\r\n");      
+    int num = setup->wIndex & 0x0f;
+
+    // Endpoint 0, and the others once configured
+    if((setup->wIndex & 0x70) || num > STREAM_ENDPOINT
+            || (num != 0 && device_state != ENUMERATED)) {
+        TRACE("usb: no endpoint 0x%02lx", setup->wIndex, 0);
+        USB0_ENDPT0 |= USB_ENDPT_EPSTALL_MASK;
+        return;
+    }
+
+    switch(setup->bRequest) {
+        case mGET_STATUS:
+            endpoint_status = (USB0_ENDPT(num) & USB_ENDPT_EPSTALL_MASK) ? 1 : 0;
+            usb_queue_tx(ep, (uint8_t *) &endpoint_status, 2, setup->wLength);
+            break;
+
+        case mCLR_FEATURE:
+            if(setup->wValue != ENDPOINT_HALT) {
+                USB0_ENDPT0 |= USB_ENDPT_EPSTALL_MASK;
+                break;
+            }
+            // The next packet after a halt is DATA0.  OUT banks run
+            // without DTS, the controller takes either toggle there
+            USB0_ENDPT(num) &= ~USB_ENDPT_EPSTALL_MASK;
+            if(num != 0 && (setup->wIndex & 0x80))
+                endpoints[num].data0 = 0;
+            usb_tx(ep,0,0);                     // Status stage
+            break;
+
+        default:
+            TRACE("usb: unsupported endpoint request %lu", setup->bRequest, 0);
+            USB0_ENDPT0 |= USB_ENDPT_EPSTALL_MASK;
+            break;
+    }
 }
 
-static void usb_handler(uint8_t stat)
+static RAMFUNC void usb_handler(uint8_t stat)
 {
     unsigned int i = stat >> 2;
     USB_BDT *bdt_ptr = &bdt[i]; 
     endpoint_t *ep = &endpoints[i >> 2];
+    int hold = 0;
         
     switch(bdt_ptr->stat.PID.PID) {
         case OUT_TOKEN:
             if(ep->rx_handler)
-                (*(ep->rx_handler))(ep, bdt_ptr->addr, bdt_ptr->count);
+                hold = (*(ep->rx_handler))(ep, bdt_ptr->addr, bdt_ptr->count);
             break;
 
         case IN_TOKEN:
-            usb_tx_handler(ep, bdt_ptr);
+            if(ep->tx_handler)
+                (*(ep->tx_handler))(ep, bdt_ptr);
+            else
+                usb_tx_handler(ep);
             if(device_state == ADDRESS) {
                 USB0_ADDR = device_address;
-                iprintf("USB0_ADDR = %d\r\n", USB0_ADDR);
+                TRACE("usb: address %lu", USB0_ADDR, 0);
                 device_state = READY;       
             }
             ep->tx_last = i & 1;            // Save even/odd of last buffer sent
@@ -517,6 +849,8 @@ static void usb_handler(uint8_t stat)
             
         case SETUP_TOKEN:
             ep->data0 = _DATA01;            // Setup is always DATA1
+            ep->pending_len = 0;            // Abort any previous transfer
+            ep->zlp = 0;
             ep_clear_tx(ep, ep->tx_last);
             USB_SETUP *setup = (USB_SETUP*) bdt_ptr->addr;
             switch(setup->bmRequestType & 0x1f) {
@@ -532,13 +866,18 @@ static void usb_handler(uint8_t stat)
     // For receive buffers, configure to receive next token
     int tx = stat & 0x8;
     if(!tx) {
-        bdt_ptr->count = EP0_BUFSIZE;               // XXX: generalize this
+        if(hold) {
+            cdc_rx_held[cdc_rx_nheld++] = bdt_ptr;  // Given back by cdc_read()
+            return;
+        }
+        bdt_ptr->count = ep->size;
         bdt_ptr->stat._byte = _OWN;
     }
 }
 
-void USBOTG_IRQHandler(void) 
+RAMFUNC void USBOTG_IRQHandler(void) 
 {
+    PROF_ISR(profUSB);
     uint8_t istat = USB0_ISTAT;
     
     if(istat & USB_ISTAT_USBRST_MASK) {         // Reset
@@ -546,21 +885,37 @@ void USBOTG_IRQHandler(void)
         return;
     }
 
+    // 3 ms of idle bus: suspend, or detach.  Resume is armed only while
+    // suspended, it would fire on every bus transition otherwise
+    if(istat & USB_ISTAT_SLEEP_MASK) {
+        TRACE("usb: suspend", 0, 0);
+        suspended = 1;
+        USB_ISTAT_CLEAR(USB_ISTAT_SLEEP_MASK | USB_ISTAT_RESUME_MASK);
+        USB0_INTEN = (USB0_INTEN & ~USB_INTEN_SLEEPEN_MASK) | USB_INTEN_RESUMEEN_MASK;
+    }
+
+    if(istat & USB_ISTAT_RESUME_MASK) {
+        TRACE("usb: resume", 0, 0);
+        suspended = 0;
+        USB_ISTAT_CLEAR(USB_ISTAT_RESUME_MASK | USB_ISTAT_SLEEP_MASK);
+        USB0_INTEN = (USB0_INTEN & ~USB_INTEN_RESUMEEN_MASK) | USB_INTEN_SLEEPEN_MASK;
+    }
+
     // Process any pending token done interrupts (may be queued)
     while(istat & USB_ISTAT_TOKDNE_MASK) {
         usb_handler(USB0_STAT);
-        USB0_ISTAT = USB_ISTAT_TOKDNE_MASK;
+        USB_ISTAT_CLEAR(USB_ISTAT_TOKDNE_MASK);
         istat = USB0_ISTAT;
     }
         
     if(istat & USB_ISTAT_STALL_MASK) {
         USB0_ENDPT0 &= ~USB_ENDPT_EPSTALL_MASK;
-        USB0_ISTAT = USB_ISTAT_STALL_MASK;
+        USB_ISTAT_CLEAR(USB_ISTAT_STALL_MASK);
     }
     
     if(istat & USB_ISTAT_ERROR_MASK) {
-        iprintf("USB error: 0x%x\r\n", USB0_ERRSTAT);
-        USB0_ISTAT = USB_ISTAT_ERROR_MASK;
+        TRACE("usb: error 0x%02lx", USB0_ERRSTAT, 0);
+        USB_ISTAT_CLEAR(USB_ISTAT_ERROR_MASK);
         USB0_INTEN = 0;                             // Disable all USB interrupts
         return;
     }